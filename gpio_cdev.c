@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_cdev.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief GPIO character device(/dev/gpiochipN, v2 uAPI) transport for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <ctype.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "gpio_port.h"
+
+//------------------------------------------------------------------------------
+#define GPIO_CDEV_CONSUMER  "lib_i2c"
+
+//------------------------------------------------------------------------------
+// SCL/SDA 는 하나의 line request 로 요청하므로 값/방향 설정은 edge 당 ioctl 1회.
+//------------------------------------------------------------------------------
+struct gpio_cdev {
+    int         fd_request;
+    /* GPIO_V2_LINE_FLAG_OPEN_DRAIN 으로 설정된 line */
+    uint32_t    od_mask;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      cdev_set_value  (struct gpio_port *port, uint32_t mask, uint32_t value);
+static int      cdev_get_value  (struct gpio_port *port, uint32_t mask, uint32_t *value);
+static int      cdev_direction  (struct gpio_port *port, uint32_t mask, uint32_t out);
+static int      cdev_open_drain (struct gpio_port *port, uint32_t mask, int enable);
+static void     cdev_close      (struct gpio_port *port);
+static void     cdev_config     (struct gpio_v2_line_config *config, uint32_t lines_mask,
+                                 uint32_t out, uint32_t value, uint32_t od);
+
+//------------------------------------------------------------------------------
+int gpio_cdev_open (struct gpio_port *port, const char *chip, const int *offset, int lines);
+
+static const struct gpio_port_ops cdev_ops = {
+    .set_value  = cdev_set_value,
+    .get_value  = cdev_get_value,
+    .direction  = cdev_direction,
+    .open_drain = cdev_open_drain,
+    .close      = cdev_close,
+};
+
+//------------------------------------------------------------------------------
+static int cdev_set_value (struct gpio_port *port, uint32_t mask, uint32_t value)
+{
+    struct gpio_cdev *cdev = port->priv;
+    struct gpio_v2_line_values values;
+
+    /* input line 은 설정할 수 없으므로 출력 전환시 (port->value) 적용 */
+    if (!(mask &= port->dir))
+        return 1;
+    values.bits = value;
+    values.mask = mask;
+    if (ioctl (cdev->fd_request, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+        printf ("%s error : mask = 0x%02x\n", __func__, mask);
+        return 0;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int cdev_get_value (struct gpio_port *port, uint32_t mask, uint32_t *value)
+{
+    struct gpio_cdev *cdev = port->priv;
+    struct gpio_v2_line_values values;
+
+    values.bits = 0;
+    values.mask = mask;
+    if (ioctl (cdev->fd_request, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        printf ("%s error : mask = 0x%02x\n", __func__, mask);
+        return 0;
+    }
+    *value = (uint32_t)(values.bits & mask);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// line 설정은 request 전체에 대해 다시 적용되므로 mask 밖의 line 은 현재 방향을 유지.
+// od 가 설정되면 (모든 line) 출력을 open-drain 으로 요청.
+//------------------------------------------------------------------------------
+static void cdev_config (struct gpio_v2_line_config *config, uint32_t lines_mask,
+                         uint32_t out, uint32_t value, uint32_t od)
+{
+    uint64_t out_flags = GPIO_V2_LINE_FLAG_OUTPUT | (od ? GPIO_V2_LINE_FLAG_OPEN_DRAIN : 0);
+
+    memset (config, 0, sizeof(struct gpio_v2_line_config));
+
+    out &= lines_mask;
+    if (out == lines_mask) {
+        config->flags = out_flags;
+    } else {
+        config->flags = GPIO_V2_LINE_FLAG_INPUT;
+        if (out) {
+            config->attrs[config->num_attrs].attr.id    = GPIO_V2_LINE_ATTR_ID_FLAGS;
+            config->attrs[config->num_attrs].attr.flags = out_flags;
+            config->attrs[config->num_attrs].mask       = out;
+            config->num_attrs++;
+        }
+    }
+    if (out) {
+        config->attrs[config->num_attrs].attr.id     = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        config->attrs[config->num_attrs].attr.values = value & out;
+        config->attrs[config->num_attrs].mask        = out;
+        config->num_attrs++;
+    }
+}
+
+//------------------------------------------------------------------------------
+static int cdev_direction (struct gpio_port *port, uint32_t mask, uint32_t out)
+{
+    struct gpio_cdev *cdev = port->priv;
+    struct gpio_v2_line_config config;
+    uint32_t lines_mask = GPIO_LINE_BIT(port->lines) - 1;
+
+    out = (port->dir & ~mask) | (out & mask);
+    cdev_config (&config, lines_mask, out, port->value, cdev->od_mask);
+
+    if (ioctl (cdev->fd_request, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+        printf ("%s error : mask = 0x%02x\n", __func__, mask);
+        return 0;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 모든 line 을 출력으로 두고 open-drain flag 만 바꿈 (값 1 = release).
+// 현재 kernel 설정은 request 단위이므로 mask 는 모든 line 이어야 함.
+//------------------------------------------------------------------------------
+static int cdev_open_drain (struct gpio_port *port, uint32_t mask, int enable)
+{
+    struct gpio_cdev *cdev = port->priv;
+    struct gpio_v2_line_config config;
+    uint32_t lines_mask = GPIO_LINE_BIT(port->lines) - 1;
+
+    if ((mask & lines_mask) != lines_mask)
+        return 0;
+
+    cdev_config (&config, lines_mask, lines_mask, port->value, enable ? lines_mask : 0);
+    if (ioctl (cdev->fd_request, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+        printf ("%s error : mask = 0x%02x\n", __func__, mask);
+        return 0;
+    }
+    cdev->od_mask = enable ? lines_mask : 0;
+    port->dir     = lines_mask;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void cdev_close (struct gpio_port *port)
+{
+    struct gpio_cdev *cdev = port->priv;
+
+    if (cdev == NULL)
+        return;
+
+    if (cdev->fd_request >= 0)
+        close (cdev->fd_request);
+    free (cdev);
+    port->priv = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/* chip 은 chip 번호("0") 또는 device node 경로("/dev/gpiochip0") */
+//------------------------------------------------------------------------------
+int gpio_cdev_open (struct gpio_port *port, const char *chip, const int *offset, int lines)
+{
+    struct gpio_v2_line_request req;
+    struct gpio_cdev *cdev;
+    char fname[256];
+    int fd, i;
+
+    if ((lines <= 0) || (lines > GPIO_LINE_MAX) || (chip == NULL))
+        return 0;
+
+    memset (fname, 0x00, sizeof(fname));
+    if (isdigit ((unsigned char)chip[0]))
+        snprintf (fname, sizeof(fname), "/dev/gpiochip%d", atoi (chip));
+    else
+        snprintf (fname, sizeof(fname), "%s", chip);
+
+    if ((fd = open (fname, O_RDWR | O_CLOEXEC)) < 0) {
+        printf ("%s error : Unable to open %s\n", __func__, fname);
+        return 0;
+    }
+
+    memset (&req, 0, sizeof(req));
+    for (i = 0; i < lines; i++)
+        req.offsets[i] = offset[i];
+    req.num_lines = lines;
+    strncpy (req.consumer, GPIO_CDEV_CONSUMER, sizeof(req.consumer) - 1);
+    /* 모든 line 출력, high (bus idle) 로 요청 */
+    cdev_config (&req.config, GPIO_LINE_BIT(lines) - 1,
+                 GPIO_LINE_BIT(lines) - 1, GPIO_LINE_BIT(lines) - 1, 0);
+
+    if (ioctl (fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        printf ("%s error : line request failed (%s)\n", __func__, fname);
+        close (fd);
+        return 0;
+    }
+    /* line request fd 는 chip fd 와 독립적으로 유지됨 */
+    close (fd);
+
+    if ((cdev = calloc (1, sizeof(struct gpio_cdev))) == NULL) {
+        close (req.fd);
+        return 0;
+    }
+    cdev->fd_request = req.fd;
+
+    port->ops   = &cdev_ops;
+    port->lines = lines;
+    port->priv  = cdev;
+    port->value = port->dir = GPIO_LINE_BIT(lines) - 1;
+    for (i = 0; i < lines; i++)
+        port->gpio[i] = offset[i];
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
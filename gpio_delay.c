@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_delay.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Calibrated high resolution delay for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+#define CALIB_SLEEP_NS      50000
+#define CALIB_SLEEP_CNT     16
+#define CALIB_CLOCK_CNT     1000
+#define CALIB_LOOP_CNT      100000
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static void     spin_loops      (uint32_t loops);
+static int      cmp_u64         (const void *a, const void *b);
+static void     delay_calibrate (void);
+
+//------------------------------------------------------------------------------
+void     gpio_delay_init     (void);
+void     gpio_delay_calib    (struct gpio_delay_calib *calib);
+uint64_t gpio_delay_now      (void);
+void     gpio_delay_until    (uint64_t deadline_ns);
+void     gpio_delay_ns       (uint32_t ns);
+
+static struct gpio_delay_calib DelayCalib;
+static pthread_once_t DelayOnce = PTHREAD_ONCE_INIT;
+
+//------------------------------------------------------------------------------
+uint64_t gpio_delay_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void spin_loops (uint32_t loops)
+{
+    volatile uint32_t i;
+
+    for (i = 0; i < loops; i++)
+        ;
+}
+
+//------------------------------------------------------------------------------
+static int cmp_u64 (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------
+static void delay_calibrate (void)
+{
+    uint64_t over[CALIB_SLEEP_CNT], t_start, t_end = 0;
+    struct timespec ts;
+    int i;
+
+    /* clock_gettime 비용 */
+    t_start = gpio_delay_now ();
+    for (i = 0; i < CALIB_CLOCK_CNT; i++)
+        t_end = gpio_delay_now ();
+    DelayCalib.clock_cost_ns = (uint32_t)((t_end - t_start) / CALIB_CLOCK_CNT);
+
+    /* spin loop 속도 */
+    t_start = gpio_delay_now ();
+    spin_loops (CALIB_LOOP_CNT);
+    t_end   = gpio_delay_now ();
+    DelayCalib.loops_per_us = (uint32_t)((CALIB_LOOP_CNT * 1000ull) /
+                                         ((t_end - t_start) ? (t_end - t_start) : 1));
+    if (!DelayCalib.loops_per_us)
+        DelayCalib.loops_per_us = 1;
+
+    /* clock_nanosleep wake-up 지연. 90% 지점을 slack 으로 사용 */
+    for (i = 0; i < CALIB_SLEEP_CNT; i++) {
+        uint64_t deadline = gpio_delay_now () + CALIB_SLEEP_NS;
+
+        ts.tv_sec  = deadline / 1000000000ull;
+        ts.tv_nsec = deadline % 1000000000ull;
+        while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+        t_end   = gpio_delay_now ();
+        over[i] = (t_end > deadline) ? (t_end - deadline) : 0;
+    }
+    qsort (over, CALIB_SLEEP_CNT, sizeof(uint64_t), cmp_u64);
+    DelayCalib.sleep_slack_ns = (uint32_t)over[(CALIB_SLEEP_CNT * 9) / 10];
+}
+
+//------------------------------------------------------------------------------
+void gpio_delay_init (void)
+{
+    pthread_once (&DelayOnce, delay_calibrate);
+}
+
+//------------------------------------------------------------------------------
+void gpio_delay_calib (struct gpio_delay_calib *calib)
+{
+    gpio_delay_init ();
+    memcpy (calib, &DelayCalib, sizeof(struct gpio_delay_calib));
+}
+
+//------------------------------------------------------------------------------
+// 긴 대기는 (deadline - slack) 까지 clock_nanosleep, 나머지는 clock 을 보며 spin.
+//------------------------------------------------------------------------------
+void gpio_delay_until (uint64_t deadline_ns)
+{
+    uint64_t now = gpio_delay_now ();
+    struct timespec ts;
+
+    if (now >= deadline_ns)
+        return;
+
+    if ((deadline_ns - now) > (DelayCalib.sleep_slack_ns + GPIO_DELAY_SPIN_NS)) {
+        uint64_t wake = deadline_ns - DelayCalib.sleep_slack_ns;
+
+        ts.tv_sec  = wake / 1000000000ull;
+        ts.tv_nsec = wake % 1000000000ull;
+        while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+    }
+    while (gpio_delay_now () < deadline_ns)
+        ;
+}
+
+//------------------------------------------------------------------------------
+void gpio_delay_ns (uint32_t ns)
+{
+    /* clock 호출 몇번 비용보다 짧은 대기는 calibrated loop 사용 */
+    if (ns <= (DelayCalib.clock_cost_ns * 4)) {
+        spin_loops ((uint32_t)(((uint64_t)ns * DelayCalib.loops_per_us) / 1000));
+        return;
+    }
+    gpio_delay_until (gpio_delay_now () + ns);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,44 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_delay.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Calibrated high resolution delay for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __GPIO_DELAY_H__
+#define __GPIO_DELAY_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// 이 시간 이하의 대기는 sleep 없이 busy-spin 으로만 처리함.
+//------------------------------------------------------------------------------
+#define GPIO_DELAY_SPIN_NS      10000
+
+struct gpio_delay_calib {
+    /* clock_nanosleep 의 wake-up 지연 (sleep 을 이만큼 일찍 끝내고 spin) */
+    uint32_t    sleep_slack_ns;
+    /* clock_gettime(CLOCK_MONOTONIC) 1회 비용 */
+    uint32_t    clock_cost_ns;
+    /* clock 호출보다 짧은 대기에 사용하는 spin loop 횟수 (1us 당) */
+    uint32_t    loops_per_us;
+};
+
+//------------------------------------------------------------------------------
+extern void     gpio_delay_init     (void);
+extern void     gpio_delay_calib    (struct gpio_delay_calib *calib);
+extern uint64_t gpio_delay_now      (void);
+extern void     gpio_delay_until    (uint64_t deadline_ns);
+extern void     gpio_delay_ns       (uint32_t ns);
+
+//------------------------------------------------------------------------------
+#endif  // __GPIO_DELAY_H__
+//------------------------------------------------------------------------------
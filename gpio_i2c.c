@@ -22,313 +22,1075 @@
 #include <string.h>
 #include <time.h>
 #include <fcntl.h>
+#include <math.h>
 
 #include "lib_i2c.h"
 #include "gpio_i2c.h"
+#include "gpio_port.h"
+#include "gpio_delay.h"
+#include "gpio_wave.h"
 
 //------------------------------------------------------------------------------
-#define	GPIO_CONTROL_PATH   "/sys/class/gpio"
-#define GPIO_SET_DELAY      50
+#define GPIO_CLK_MIN        1
+#define GPIO_CLK_MAX        1000000
 #define	GPIO_DIR_OUT        1
 #define	GPIO_DIR_IN         0
 
 #define I2C_READ_FLAG       0x01
 
+/* SCL/SDA 출력 방식 */
+#define GPIO_OD_NONE        0
+/* 출력 low = output, release = input 으로 전환 (모든 transport) */
+#define GPIO_OD_EMUL        1
+/* transport 의 open-drain 출력 (chardev), 값 1 = release */
+#define GPIO_OD_NATIVE      2
+
 enum {  LOW = 0, HIGH = 1, };
 
+//------------------------------------------------------------------------------
+// GPIO bus 별 context. 여러 bus 를 동시에 (bus 당 thread 1개) 사용할 수 있음.
+//------------------------------------------------------------------------------
+struct gpio_i2c {
+    /* SCL/SDA line transport (sysfs, gpiochip or gpiomem) */
+    struct gpio_port    port;
+    /* SDA lane 수와 모든 lane 의 line mask (lane 0 = GPIO_LINE_SDA) */
+    int                 lanes;
+    uint32_t            sda_mask;
+    /* bus clock : half period 와 다음 edge 의 deadline */
+    uint32_t            clock;
+    uint32_t            half_ns;
+    uint64_t            deadline;
+    /* open-drain 방식, clock stretching 제한 시간 */
+    int                 od;
+    uint64_t            stretch_ns;
+    /* transaction 중 clock stretching timeout 발생 */
+    int                 timeout;
+    /* SDA 가 잡혀 있어 bus recovery (SCL pulse + STOP) 를 한 횟수 */
+    uint32_t            recover;
+    /* compile 된 transaction waveform (gpio_wave.c) */
+    struct gpio_wave_cache  wave;
+};
+
 //------------------------------------------------------------------------------
 // function prototype
 //------------------------------------------------------------------------------
-static int      gpio_export     (int gpio);
-static int      gpio_direction  (int gpio, int status);
-static int      gpio_set_value  (int gpio, int s_value);
-static int      gpio_get_value  (int gpio, int *g_value);
-static int      gpio_unexport   (int gpio);
-static void     gpio_i2c_start  (int restart);
-static void     gpio_i2c_stop   (void);
-static int      i2c_write_bits  (uint8_t wd);
-static int      i2c_read_bits   (void);
+static int      gpio_dir_mask   (struct gpio_i2c *gi, uint32_t mask, uint32_t out);
+static int      gpio_set_mask   (struct gpio_i2c *gi, uint32_t mask, uint32_t value);
+static int      gpio_direction  (struct gpio_i2c *gi, int line, int status);
+static int      gpio_set_value  (struct gpio_i2c *gi, int line, int s_value);
+static int      gpio_get_value  (struct gpio_i2c *gi, int line, int *g_value);
+static int      gpio_wait_scl   (struct gpio_i2c *gi);
+static void     gpio_i2c_start  (struct gpio_i2c *gi, int restart);
+static void     gpio_i2c_stop   (struct gpio_i2c *gi);
+static int      i2c_write_bits  (struct gpio_i2c *gi, uint8_t wd);
+static int      i2c_read_bits   (struct gpio_i2c *gi);
+static void     i2c_send_ack    (struct gpio_i2c *gi, int ack);
+static void     i2c_delay       (struct gpio_i2c *gi);
+static int      i2c_wave_run    (struct gpio_i2c *gi, const struct gpio_wave *wave, uint8_t *sample);
+static int      i2c_sda_free    (struct gpio_i2c *gi);
+static int      i2c_fail        (struct gpio_i2c *gi);
 
-static int gpio_i2c_write (struct i2c_smbus_ioctl_data *args);
-static int gpio_i2c_read  (struct i2c_smbus_ioctl_data *args);
+static void     lane_sda        (struct gpio_i2c *gi, uint32_t active, uint32_t value);
+static void     lane_start      (struct gpio_i2c *gi, uint32_t active, int restart);
+static void     lane_stop       (struct gpio_i2c *gi);
+static uint32_t lane_write_byte (struct gpio_i2c *gi, uint32_t active, const uint8_t *wd);
+static void     lane_read_byte  (struct gpio_i2c *gi, uint32_t active, uint8_t *rd, uint32_t ack);
 
-//------------------------------------------------------------------------------
-int     gpio_i2c_init   (int scl_gpio, int sda_gpio);
-void    gpio_i2c_close  (void);
-int     gpio_i2c_ctrl   (struct i2c_smbus_ioctl_data *args);
+static struct gpio_i2c *gpio_i2c_alloc  (int lanes);
+static struct gpio_i2c *gpio_i2c_setup  (struct gpio_i2c *gi);
 
-int GPIO_I2C_SDA = 0, GPIO_I2C_SCL = 0;
+//------------------------------------------------------------------------------
+struct gpio_i2c *gpio_i2c_init      (int scl_gpio, const int *sda_gpio, int lanes, int keep);
+struct gpio_i2c *gpio_i2c_init_chip (const char *chip, int scl_offset, const int *sda_offset, int lanes);
+struct gpio_i2c *gpio_i2c_init_mmap (const char *board, const char *path,
+                                     int scl_gpio, const int *sda_gpio, int lanes);
+void     gpio_i2c_close     (struct gpio_i2c *gi);
+int      gpio_i2c_ctrl      (struct gpio_i2c *gi, int addr, struct i2c_smbus_ioctl_data *args);
+int      gpio_i2c_transfer  (struct gpio_i2c *gi, struct i2c_msg *msgs, int nmsgs);
+int      gpio_i2c_transfer_lanes (struct gpio_i2c *gi, struct i2c_msg **msgs, int nmsgs,
+                                  uint32_t *lanes);
+int      gpio_i2c_get_lanes (struct gpio_i2c *gi);
+double   gpio_i2c_bench     (struct gpio_i2c *gi, int edges);
+int      gpio_i2c_set_clock (struct gpio_i2c *gi, uint32_t clock_hz);
+uint32_t gpio_i2c_get_clock (struct gpio_i2c *gi);
+int      gpio_i2c_set_open_drain (struct gpio_i2c *gi, int enable, uint32_t stretch_us);
+int      gpio_i2c_recover   (struct gpio_i2c *gi);
+uint32_t gpio_i2c_get_recover (struct gpio_i2c *gi);
+int      gpio_i2c_selftest  (struct gpio_i2c *gi, int cycles, struct gpio_i2c_clock_stat *stat);
 
 //------------------------------------------------------------------------------
-static void udelay (int delay)
+// 이전 delay 종료 시점 기준으로 half period 를 맞춤. (gpio 접근 시간은 period 에 포함)
+// 이미 늦은 경우(bus idle 이후 등)는 기다리지 않고 현재 시점부터 다시 시작.
+//------------------------------------------------------------------------------
+static void i2c_delay (struct gpio_i2c *gi)
 {
-    usleep (delay);
+    uint64_t now = gpio_delay_now ();
+
+    gi->deadline += gi->half_ns;
+    if (gi->deadline <= now) {
+        gi->deadline = now;
+        return;
+    }
+    gpio_delay_until (gi->deadline);
 }
 
 //------------------------------------------------------------------------------
-static int gpio_export (int gpio)
+// 방향은 line 별로 cache 되어 있으므로 이미 같은 방향인 line 은 transport 를 호출하지 않음.
+// open-drain 에서는 출력 전환이 없고 input 은 line release (high) 와 같음.
+//------------------------------------------------------------------------------
+static int gpio_dir_mask (struct gpio_i2c *gi, uint32_t mask, uint32_t out)
 {
-    char fname[256];
-    FILE *fp;
+    struct gpio_port *port = &gi->port;
 
-    memset (fname, 0x00, sizeof(fname));
-    sprintf (fname, "%s/export", GPIO_CONTROL_PATH);
-    if ((fp = fopen (fname, "w")) != NULL) {
-        char gpio_num[4];
-        memset (gpio_num, 0x00, sizeof(gpio_num));
-        sprintf (gpio_num, "%d", gpio);
-        fwrite (gpio_num, strlen(gpio_num), 1, fp);
-        fclose (fp);
+    if (gi->od)
+        return out ? 1 : gpio_set_mask (gi, mask, mask);
+
+    out = (port->dir & ~mask) | (out & mask);
+    if (out == port->dir)
         return 1;
-    }
-    printf ("%s error : gpio = %d\n", __func__, gpio);
-    return 0;
+
+    if (!port->ops->direction (port, out ^ port->dir, out & ~port->dir))
+        return 0;
+
+    port->dir = out;
+    return 1;
 }
 
 //------------------------------------------------------------------------------
-static int gpio_direction (int gpio, int status)
+// mask 의 line 을 한번에 설정 (multi-lane 의 SDA 는 transport 호출 1회).
+// open-drain (EMUL) : low 는 output (출력값 0), high 는 input 으로 release.
+//------------------------------------------------------------------------------
+static int gpio_set_mask (struct gpio_i2c *gi, uint32_t mask, uint32_t value)
 {
-    char fname[256];
-    FILE *fp;
+    struct gpio_port *port = &gi->port;
+    uint32_t out;
 
-    memset (fname, 0x00, sizeof(fname));
-    sprintf (fname, "%s/gpio%d/direction", GPIO_CONTROL_PATH, gpio);
-    if ((fp = fopen (fname, "w")) != NULL) {
-        char gpio_status[4];
-        memset (gpio_status, 0x00, sizeof(gpio_status));
-        sprintf(gpio_status, "%s", status ? "out" : "in");
-        fwrite (gpio_status, strlen(gpio_status), 1, fp);
-        fclose (fp);
+    value &= mask;
+    /* 출력값은 gpio_i2c_set_open_drain 에서 0 으로 설정해 두었으므로 방향 전환만 사용 */
+    if (gi->od == GPIO_OD_EMUL) {
+        out = (port->dir & ~mask) | (mask & ~value);
+        if (out != port->dir) {
+            if (!port->ops->direction (port, out ^ port->dir, out & ~port->dir))
+                return 0;
+            port->dir = out;
+        }
         return 1;
     }
-    printf ("%s error : gpio = %d\n", __func__, gpio);
-    return 0;
+    if (!port->ops->set_value (port, mask, value))
+        return 0;
+    port->value = (port->value & ~mask) | value;
+    return 1;
 }
 
 //------------------------------------------------------------------------------
-static int gpio_set_value (int gpio, int s_value)
+static int gpio_direction (struct gpio_i2c *gi, int line, int status)
 {
-    char fname[256];
-    FILE *fp;
+    uint32_t bit = GPIO_LINE_BIT(line);
 
-    memset (fname, 0x00, sizeof(fname));
-    sprintf (fname, "%s/gpio%d/value", GPIO_CONTROL_PATH, gpio);
-    if ((fp = fopen (fname, "w")) != NULL) {
-        fputc (s_value ? '1' : '0', fp);
-        fclose (fp);
-        return 1;
-    }
-    printf ("%s error : gpio = %d\n", __func__, gpio);
-    return 0;
+    return gpio_dir_mask (gi, bit, status ? bit : 0);
 }
 
 //------------------------------------------------------------------------------
-static int gpio_get_value (int gpio, int *g_value)
+// open-drain 에서 SCL 을 release 하면 slave 의 clock stretching 이 끝날 때까지 기다림.
+//------------------------------------------------------------------------------
+static int gpio_set_value (struct gpio_i2c *gi, int line, int s_value)
 {
-    char fname[256];
-    FILE *fp;
+    uint32_t bit = GPIO_LINE_BIT(line);
 
-    memset (fname, 0x00, sizeof(fname));
-    sprintf (fname, "%s/gpio%d/value", GPIO_CONTROL_PATH, gpio);
-    if ((fp = fopen (fname, "r")) != NULL) {
-        *g_value = (fgetc (fp) - '0');
-        fclose (fp);
-        return 1;
-    }
-    printf ("%s error : gpio = %d\n", __func__, gpio);
-    return 0;
+    if (!gpio_set_mask (gi, bit, s_value ? bit : 0))
+        return 0;
+
+    if (gi->od && s_value && (line == GPIO_LINE_SCL))
+        return gpio_wait_scl (gi);
+    return 1;
 }
 
 //------------------------------------------------------------------------------
-static int gpio_unexport (int gpio)
+static int gpio_get_value (struct gpio_i2c *gi, int line, int *g_value)
 {
-    char fname[256];
-    FILE *fp;
+    struct gpio_port *port = &gi->port;
+    uint32_t value;
 
-    memset (fname, 0x00, sizeof(fname));
-    sprintf (fname, "%s/unexport", GPIO_CONTROL_PATH);
-    if ((fp = fopen (fname, "w")) != NULL) {
-        char gpio_num[4];
-        memset (gpio_num, 0x00, sizeof(gpio_num));
-        sprintf (gpio_num, "%d", gpio);
-        fwrite (gpio_num, strlen(gpio_num), 1, fp);
-        fclose (fp);
-        return 1;
+    if (!port->ops->get_value (port, GPIO_LINE_BIT(line), &value))
+        return 0;
+
+    *g_value = value ? 1 : 0;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// SCL 을 다시 읽어 slave 가 clock 을 잡고 있으면 (clock stretching) high 가 될 때까지 대기.
+// stretch_ns 를 넘으면 timeout (errno = ETIMEDOUT) 으로 0.
+//------------------------------------------------------------------------------
+static int gpio_wait_scl (struct gpio_i2c *gi)
+{
+    struct gpio_port *port = &gi->port;
+    uint32_t bit = GPIO_LINE_BIT(GPIO_LINE_SCL), value;
+    uint64_t now, limit = 0;
+
+    while (1) {
+        if (!port->ops->get_value (port, bit, &value))
+            return 0;
+        if (value)
+            return 1;
+
+        now = gpio_delay_now ();
+        if (!limit)
+            limit = now + gi->stretch_ns;
+        else if (now >= limit)
+            break;
     }
-    printf ("%s error : gpio = %d\n", __func__, gpio);
+    gi->timeout = 1;
+    errno = ETIMEDOUT;
     return 0;
 }
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-static void gpio_i2c_start     (int restart)
+static void gpio_i2c_start     (struct gpio_i2c *gi, int restart)
 {
-    if (!GPIO_I2C_SDA || !GPIO_I2C_SCL)     return;
-
-    gpio_set_value (GPIO_I2C_SDA, LOW); udelay(GPIO_SET_DELAY);
-    gpio_set_value (GPIO_I2C_SCL, LOW); udelay(GPIO_SET_DELAY);
+    gpio_set_value (gi, GPIO_LINE_SDA, LOW);    i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
     if (restart) {
-        gpio_set_value (GPIO_I2C_SDA, HIGH);    udelay(GPIO_SET_DELAY);
-        gpio_set_value (GPIO_I2C_SCL, HIGH);    udelay(GPIO_SET_DELAY);
-        gpio_set_value (GPIO_I2C_SDA, LOW);     udelay(GPIO_SET_DELAY);
-        gpio_set_value (GPIO_I2C_SCL, LOW);     udelay(GPIO_SET_DELAY);
+        gpio_set_value (gi, GPIO_LINE_SDA, HIGH);   i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SDA, LOW);    i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
     }
 }
 
 /*---------------------------------------------------------------------------*/
-static void gpio_i2c_stop      (void)
+static void gpio_i2c_stop      (struct gpio_i2c *gi)
 {
-    gpio_set_value (GPIO_I2C_SCL, HIGH);    udelay(GPIO_SET_DELAY);
-    gpio_set_value (GPIO_I2C_SDA, HIGH);    udelay(GPIO_SET_DELAY);
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+    gpio_set_mask  (gi, gi->sda_mask, gi->sda_mask);    i2c_delay(gi);
 }
 
 /*---------------------------------------------------------------------------*/
-static int i2c_write_bits   (uint8_t wd)
+static int i2c_write_bits   (struct gpio_i2c *gi, uint8_t wd)
 {
     int i;
 
     for (i = 0; i < 8; i++) {
-        gpio_set_value (GPIO_I2C_SDA, (wd & 0x80) ? HIGH : LOW);
+        gpio_set_value (gi, GPIO_LINE_SDA, (wd & 0x80) ? HIGH : LOW);
         wd <<= 1;
-        gpio_set_value (GPIO_I2C_SCL, HIGH);    udelay(GPIO_SET_DELAY);
-        gpio_set_value (GPIO_I2C_SCL, LOW);     udelay(GPIO_SET_DELAY);
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
     }
     // ack check
-    gpio_set_value (GPIO_I2C_SCL, HIGH);        udelay(GPIO_SET_DELAY);
-    gpio_direction (GPIO_I2C_SDA, GPIO_DIR_IN); udelay(GPIO_SET_DELAY);
-    gpio_get_value (GPIO_I2C_SDA, &i);
-    gpio_direction (GPIO_I2C_SDA, GPIO_DIR_OUT);udelay(GPIO_SET_DELAY);
-    gpio_set_value (GPIO_I2C_SCL, LOW);         udelay(GPIO_SET_DELAY);
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);           i2c_delay(gi);
+    gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_IN);    i2c_delay(gi);
+    gpio_get_value (gi, GPIO_LINE_SDA, &i);
+    gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_OUT);   i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);            i2c_delay(gi);
 
     return i;
 }
 
 /*---------------------------------------------------------------------------*/
-static int i2c_read_bits   (void)
+static int i2c_read_bits   (struct gpio_i2c *gi)
 {
     int i, rd, rb;
 
-    gpio_direction (GPIO_I2C_SDA, GPIO_DIR_IN);
+    gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_IN);
     for (i = 0, rd = 0, rb = 0; i < 8; i++) {
-        gpio_set_value (GPIO_I2C_SCL, HIGH);    udelay(GPIO_SET_DELAY);
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
         rd <<= 1;
-        gpio_get_value (GPIO_I2C_SDA, &rb);
+        gpio_get_value (gi, GPIO_LINE_SDA, &rb);
         rd |= rb ? 1 : 0;
-        gpio_set_value (GPIO_I2C_SCL, LOW);     udelay(GPIO_SET_DELAY);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
     }
-    gpio_direction (GPIO_I2C_SDA, GPIO_DIR_OUT);
+    gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_OUT);
 
     return rd;
 }
 
 /*---------------------------------------------------------------------------*/
-static int gpio_i2c_write (struct i2c_smbus_ioctl_data *args)
+static void i2c_send_ack   (struct gpio_i2c *gi, int ack)
 {
-    uint16_t i = 0;
-    union i2c_smbus_data *pdata = args->data;
+    gpio_set_value (gi, GPIO_LINE_SDA, ack ? LOW : HIGH);   i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SDA, HIGH);   i2c_delay(gi);
+}
+
+//------------------------------------------------------------------------------
+// compile 된 waveform 을 실행. 함수 호출/protocol 판단 없이 edge 동작만 반복하고
+// read bit 는 sample 에 저장 (decode 는 실행 후). NACK 이면 ACK clock 과 STOP 후 -1.
+//------------------------------------------------------------------------------
+static int i2c_wave_run (struct gpio_i2c *gi, const struct gpio_wave *wave, uint8_t *sample)
+{
+    struct gpio_port *port = &gi->port;
+    const struct gpio_port_ops *ops = port->ops;
+    const uint32_t sda = GPIO_LINE_BIT(GPIO_LINE_SDA);
+    uint32_t value;
+    int pc, ret = 0;
+
+    for (pc = 0; ; pc++) {
+        switch (wave->op[pc]) {
+            case eGPIO_WAVE_SCL_LO:
+                gpio_set_value (gi, GPIO_LINE_SCL, LOW);
+                break;
+            /* clock stretching timeout 이면 bus 상태를 알 수 없으므로 바로 종료 */
+            case eGPIO_WAVE_SCL_HI:
+                if (!gpio_set_value (gi, GPIO_LINE_SCL, HIGH) && gi->timeout)
+                    return -1;
+                break;
+            case eGPIO_WAVE_SDA_LO:
+                gpio_set_value (gi, GPIO_LINE_SDA, LOW);
+                break;
+            case eGPIO_WAVE_SDA_HI:
+                gpio_set_value (gi, GPIO_LINE_SDA, HIGH);
+                break;
+            case eGPIO_WAVE_SDA_IN:
+                gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_IN);
+                break;
+            case eGPIO_WAVE_SDA_OUT:
+                gpio_direction (gi, GPIO_LINE_SDA, GPIO_DIR_OUT);
+                break;
+            case eGPIO_WAVE_DELAY:
+                i2c_delay (gi);
+                break;
+            case eGPIO_WAVE_SAMPLE:
+                value = 0;
+                ops->get_value (port, sda, &value);
+                *sample++ = value ? 1 : 0;
+                break;
+            case eGPIO_WAVE_ACK:
+                if (!ops->get_value (port, sda, &value) || value)
+                    ret = -1;
+                break;
+            case eGPIO_WAVE_ACK_IGN:
+                ops->get_value (port, sda, &value);
+                break;
+            case eGPIO_WAVE_CHECK:
+                if (ret)
+                    pc = wave->stop - 1;
+                break;
+            case eGPIO_WAVE_END:
+            default:
+                return ret;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// 모든 lane 의 SDA 를 release 하고 읽음. 잡고 있는 slave 가 없으면 (모두 high) 1.
+// push-pull 에서는 다시 high 출력으로 돌아감.
+//------------------------------------------------------------------------------
+static int i2c_sda_free (struct gpio_i2c *gi)
+{
+    struct gpio_port *port = &gi->port;
+    uint32_t sda;
 
-    gpio_i2c_stop  ();
+    gpio_dir_mask (gi, gi->sda_mask, 0);
+    if (!port->ops->get_value (port, gi->sda_mask, &sda))
+        sda = gi->sda_mask;
+    gpio_dir_mask (gi, gi->sda_mask, gi->sda_mask);
+    gpio_set_mask (gi, gi->sda_mask, gi->sda_mask);
+
+    return sda == gi->sda_mask;
+}
 
-    gpio_i2c_start (0);
-    if (i2c_write_bits (I2C_SLAVE_ADDR))    goto wr_out;
-    if (args->size == 0)    {   i = 1;      goto wr_out;    }
-    if (i2c_write_bits (args->command))     goto wr_out;
+//------------------------------------------------------------------------------
+// transaction 실패 후 처리. slave 가 byte 중간에서 SDA 를 잡고 있으면 bus 를 풀어둠
+// (errno 는 실패 원인을 유지). 항상 -1.
+//------------------------------------------------------------------------------
+static int i2c_fail (struct gpio_i2c *gi)
+{
+    int err = errno;
 
-    for (i = 0; i < args->size; i++)
-        if (i2c_write_bits (pdata->block[i]))   goto wr_out;
+    gpio_i2c_recover (gi);
+    errno = err;
+    return -1;
+}
 
-wr_out:
-    gpio_i2c_stop  ();
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// multi-lane edge 동작. active 는 transaction 에 참여중인 lane 의 SDA line mask.
+// NACK 으로 빠진 lane 의 SDA 는 release (high) 로 두어 SCL 만 보이고 START 도 보지 않음.
+// 순서는 gpio_i2c_start/stop, i2c_write_bits, i2c_read_bits, i2c_send_ack 와 동일.
+//------------------------------------------------------------------------------
+static void lane_sda (struct gpio_i2c *gi, uint32_t active, uint32_t value)
+{
+    gpio_set_mask (gi, gi->sda_mask, (value & active) | (gi->sda_mask & ~active));
+}
 
-#if defined (_DEBUG_GPIO_I2C_)
-    if (i != size) {
-        printf ("%s(error) : addr = 0x%02X, reg = 0x%02X, size = %d\r\n", addr, reg, size);
+//------------------------------------------------------------------------------
+static void lane_start (struct gpio_i2c *gi, uint32_t active, int restart)
+{
+    lane_sda (gi, active, 0);                   i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+    if (restart) {
+        lane_sda (gi, active, active);              i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+        lane_sda (gi, active, 0);                   i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
     }
-#endif
-    return i;
 }
 
 //------------------------------------------------------------------------------
-static int gpio_i2c_read  (struct i2c_smbus_ioctl_data *args)
+// 마지막 STOP 은 빠진 lane 을 포함한 모든 lane 에 만듦 (SCL low 상태에서 호출).
+//------------------------------------------------------------------------------
+static void lane_stop (struct gpio_i2c *gi)
 {
-    uint16_t i = 0;
-    union i2c_smbus_data *pdata = args->data;
+    gpio_set_mask  (gi, gi->sda_mask, 0);       i2c_delay(gi);
+    gpio_i2c_stop  (gi);
+}
+
+//------------------------------------------------------------------------------
+// wd[lane] 을 lane 마다 동시에 전송. ACK 를 읽어 NACK 한 lane 의 mask 를 돌려줌.
+//------------------------------------------------------------------------------
+static uint32_t lane_write_byte (struct gpio_i2c *gi, uint32_t active, const uint8_t *wd)
+{
+    struct gpio_port *port = &gi->port;
+    uint32_t value, nack;
+    int i, lane;
+
+    for (i = 7; i >= 0; i--) {
+        for (lane = 0, value = 0; lane < gi->lanes; lane++)
+            if (wd[lane] & (1 << i))
+                value |= GPIO_LINE_BIT(GPIO_LINE_SDA + lane);
+        lane_sda (gi, active, value);
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+    }
+    // ack check
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);           i2c_delay(gi);
+    gpio_dir_mask  (gi, gi->sda_mask, 0);               i2c_delay(gi);
+    if (!port->ops->get_value (port, active, &nack))
+        nack = active;
+    gpio_dir_mask  (gi, gi->sda_mask, gi->sda_mask);    i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);            i2c_delay(gi);
+
+    return nack & active;
+}
+
+//------------------------------------------------------------------------------
+// 모든 lane 을 한번에 sample 하여 rd[lane] 에 저장. ack 의 lane 은 ACK, 나머지는 NACK.
+//------------------------------------------------------------------------------
+static void lane_read_byte (struct gpio_i2c *gi, uint32_t active, uint8_t *rd, uint32_t ack)
+{
+    struct gpio_port *port = &gi->port;
+    uint32_t value;
+    int i, lane;
+
+    memset (rd, 0, gi->lanes);
+    gpio_dir_mask (gi, gi->sda_mask, 0);
+    for (i = 0; i < 8; i++) {
+        gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+        if (!port->ops->get_value (port, active, &value))
+            value = 0;
+        for (lane = 0; lane < gi->lanes; lane++)
+            rd[lane] = (rd[lane] << 1) | ((value & GPIO_LINE_BIT(GPIO_LINE_SDA + lane)) ? 1 : 0);
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+    }
+    gpio_dir_mask (gi, gi->sda_mask, gi->sda_mask);
+
+    lane_sda (gi, active, ~ack);                i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);   i2c_delay(gi);
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+    lane_sda (gi, active, active);              i2c_delay(gi);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static struct gpio_i2c *gpio_i2c_alloc (int lanes)
+{
+    struct gpio_i2c *gi;
+
+    if ((lanes <= 0) || (lanes > GPIO_LANE_MAX)) {
+        printf ("%s error : lanes = %d (1 ~ %d)\n", __func__, lanes, GPIO_LANE_MAX);
+        return NULL;
+    }
+    if ((gi = calloc (1, sizeof(struct gpio_i2c))) == NULL)
+        return NULL;
+
+    gi->lanes      = lanes;
+    gi->sda_mask   = (GPIO_LINE_BIT(lanes) - 1) << GPIO_LINE_SDA;
+    gi->clock      = GPIO_I2C_DEFAULT_CLK;
+    gi->half_ns    = 500000000 / GPIO_I2C_DEFAULT_CLK;
+    gi->stretch_ns = (uint64_t)GPIO_I2C_STRETCH_US * 1000;
+    return gi;
+}
+
+//------------------------------------------------------------------------------
+static struct gpio_i2c *gpio_i2c_setup (struct gpio_i2c *gi)
+{
+    struct gpio_port *port = &gi->port;
+    uint32_t mask = GPIO_LINE_BIT(GPIO_LINE_SCL) | gi->sda_mask;
+
+    gpio_delay_init ();
+    gi->deadline = 0;
+
+    /* 방향 cache 의 초기값을 맞추기 위해 transport 에 직접 설정 */
+    if (port->ops->direction (port, mask, mask))
+        port->dir |= mask;
+    gpio_i2c_stop  (gi);
+
+    /* 이전 사용자가 transaction 중간에 종료한 경우 slave 가 SDA 를 잡고 있을 수 있음 */
+    gpio_i2c_recover (gi);
+    return gi;
+}
+
+//------------------------------------------------------------------------------
+// sysfs transport. keep 이면 close 후에도 export 상태를 유지함.
+// sda_gpio 는 lane 별 SDA (lanes 개). 1 = 일반 bus, 2 이상은 gpio_i2c_transfer_lanes 로
+// 모든 lane 에 동시 전송 (일반 transfer/SMBus 는 lane 0 만 사용).
+//------------------------------------------------------------------------------
+struct gpio_i2c *gpio_i2c_init (int scl_gpio, const int *sda_gpio, int lanes, int keep)
+{
+    struct gpio_i2c *gi;
+    int gpio[GPIO_LINE_MAX];
+
+    if ((gi = gpio_i2c_alloc (lanes)) == NULL)
+        return NULL;
+
+    gpio[GPIO_LINE_SCL] = scl_gpio;
+    memcpy (&gpio[GPIO_LINE_SDA], sda_gpio, sizeof(int) * lanes);
+
+    if (!gpio_sysfs_open (&gi->port, gpio, GPIO_LINE_SDA + lanes, keep)) {
+        free (gi);
+        return NULL;
+    }
+    return gpio_i2c_setup (gi);
+}
+
+//------------------------------------------------------------------------------
+struct gpio_i2c *gpio_i2c_init_chip (const char *chip, int scl_offset, const int *sda_offset, int lanes)
+{
+    struct gpio_i2c *gi;
+    int offset[GPIO_LINE_MAX];
+
+    if ((gi = gpio_i2c_alloc (lanes)) == NULL)
+        return NULL;
+
+    offset[GPIO_LINE_SCL] = scl_offset;
+    memcpy (&offset[GPIO_LINE_SDA], sda_offset, sizeof(int) * lanes);
+
+    if (!gpio_cdev_open (&gi->port, chip, offset, GPIO_LINE_SDA + lanes)) {
+        free (gi);
+        return NULL;
+    }
+    return gpio_i2c_setup (gi);
+}
+
+//------------------------------------------------------------------------------
+struct gpio_i2c *gpio_i2c_init_mmap (const char *board, const char *path,
+                                     int scl_gpio, const int *sda_gpio, int lanes)
+{
+    struct gpio_i2c *gi;
+    int gpio[GPIO_LINE_MAX];
+
+    if ((gi = gpio_i2c_alloc (lanes)) == NULL)
+        return NULL;
+
+    gpio[GPIO_LINE_SCL] = scl_gpio;
+    memcpy (&gpio[GPIO_LINE_SDA], sda_gpio, sizeof(int) * lanes);
+
+    if (!gpio_mmap_open (&gi->port, board, path, gpio, GPIO_LINE_SDA + lanes)) {
+        free (gi);
+        return NULL;
+    }
+    return gpio_i2c_setup (gi);
+}
+
+//------------------------------------------------------------------------------
+void gpio_i2c_close (struct gpio_i2c *gi)
+{
+    if (gi == NULL)
+        return;
+
+    if (gi->port.ops != NULL)
+        gi->port.ops->close (&gi->port);
+
+    gpio_wave_cache_free (&gi->wave);
+    free (gi);
+}
+
+//------------------------------------------------------------------------------
+int gpio_i2c_set_clock (struct gpio_i2c *gi, uint32_t clock_hz)
+{
+    if ((clock_hz < GPIO_CLK_MIN) || (clock_hz > GPIO_CLK_MAX)) {
+        printf ("%s error : clock = %u Hz (%d ~ %d)\n",
+            __func__, clock_hz, GPIO_CLK_MIN, GPIO_CLK_MAX);
+        return -1;
+    }
+    gi->clock   = clock_hz;
+    gi->half_ns = 500000000 / clock_hz;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t gpio_i2c_get_clock (struct gpio_i2c *gi)
+{
+    return gi->clock;
+}
+
+//------------------------------------------------------------------------------
+// bus recovery. SDA 를 slave 가 잡고 있으면 (byte 전송 중 reset/중단 등) SDA 가 풀릴 때까지
+// SCL 을 최대 9번 pulse 하여 slave 의 남은 bit 를 끝내게 한 뒤 STOP 을 만듦.
+// multi-lane bus 는 모든 lane 이 풀릴 때까지 pulse 하고 STOP 도 모든 lane 에 만듦.
+// bus 가 free 이면 0, 풀리지 않으면 -1 (errno = EBUSY).
+//------------------------------------------------------------------------------
+int gpio_i2c_recover (struct gpio_i2c *gi)
+{
+    struct gpio_port *port;
+    uint32_t sda = 0;
+    int i;
+
+    if (gi == NULL)
+        return -1;
+
+    if (i2c_sda_free (gi))
+        return 0;
+
+    port = &gi->port;
+    gi->recover++;
+    gpio_dir_mask (gi, gi->sda_mask, 0);
+    for (i = 0; (i < 9) && (sda != gi->sda_mask); i++) {
+        gpio_set_value (gi, GPIO_LINE_SCL, LOW);    i2c_delay(gi);
+        /* SCL 도 잡혀 있으면 (stretching timeout) 더 할 수 있는 것이 없음 */
+        if (!gpio_set_value (gi, GPIO_LINE_SCL, HIGH) && gi->timeout)
+            break;
+        i2c_delay(gi);
+        if (!port->ops->get_value (port, gi->sda_mask, &sda))
+            sda = 0;
+    }
+    /* STOP : SCL low 에서 SDA low, SCL high 후 SDA high */
+    gpio_set_value (gi, GPIO_LINE_SCL, LOW);            i2c_delay(gi);
+    gpio_dir_mask  (gi, gi->sda_mask, gi->sda_mask);
+    gpio_set_mask  (gi, gi->sda_mask, 0);               i2c_delay(gi);
+    gpio_i2c_stop  (gi);
+
+    if (!i2c_sda_free (gi)) {
+        errno = EBUSY;
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t gpio_i2c_get_recover (struct gpio_i2c *gi)
+{
+    return gi ? gi->recover : 0;
+}
+
+//------------------------------------------------------------------------------
+// open-drain 출력 설정. transport 가 지원하면 (chardev) native open-drain, 아니면
+// low = output, release = input 으로 emulation. SCL 을 다시 읽어 clock stretching 을 지원하며
+// stretch_us 동안 SCL 이 high 가 되지 않으면 transaction 실패 (0 이면 GPIO_I2C_STRETCH_US).
+// 해제시 모든 line 이 high 출력으로 돌아감. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int gpio_i2c_set_open_drain (struct gpio_i2c *gi, int enable, uint32_t stretch_us)
+{
+    struct gpio_port *port;
+    uint32_t mask;
+
+    if (gi == NULL)
+        return -1;
+
+    port = &gi->port;
+    mask = GPIO_LINE_BIT(GPIO_LINE_SCL) | gi->sda_mask;
+    gi->stretch_ns = (uint64_t)(stretch_us ? stretch_us : GPIO_I2C_STRETCH_US) * 1000;
 
-    gpio_i2c_stop  ();
-
-    gpio_i2c_start (0);
-    if (i2c_write_bits (I2C_SLAVE_ADDR))    goto rd_out;
-    if (args->size == 0)    {   i = 1;      goto rd_out;    }
-    if (i2c_write_bits (args->command))     goto rd_out;
-
-    // Read
-    gpio_i2c_start (1);
-    if (i2c_write_bits (I2C_SLAVE_ADDR | I2C_READ_FLAG))    goto rd_out;
-
-    for (i = 0; i < args->size; i++) {
-        pdata->block[i] = i2c_read_bits ();
-        // ack send except last byte.
-        if (i < (args->size -1)) {
-            gpio_set_value (GPIO_I2C_SDA, LOW);     udelay(GPIO_SET_DELAY);
-            gpio_set_value (GPIO_I2C_SCL, HIGH);    udelay(GPIO_SET_DELAY);
-            gpio_set_value (GPIO_I2C_SCL, LOW);     udelay(GPIO_SET_DELAY);
-            gpio_set_value (GPIO_I2C_SDA, HIGH);    udelay(GPIO_SET_DELAY);
+    if (enable) {
+        if (gi->od)
+            return 0;
+        port->value |= mask;
+        if (port->ops->open_drain && port->ops->open_drain (port, mask, 1)) {
+            gi->od = GPIO_OD_NATIVE;
+            return 0;
         }
+        /*
+         * input 으로 release 한 뒤에 출력값을 0 으로 설정.
+         * 출력값이 high 인 채로 출력 전환하면 첫 low 에서 잠깐 high 를 push-pull 로 구동함.
+         */
+        if (!port->ops->direction (port, mask, 0))
+            return -1;
+        port->dir &= ~mask;
+        if (!port->ops->set_value (port, mask, 0))
+            return -1;
+        port->value &= ~mask;
+        gi->od = GPIO_OD_EMUL;
+        return 0;
     }
-rd_out:
-    gpio_i2c_stop  ();
 
-#if defined (_DEBUG_GPIO_I2C_)
-    if (i != size) {
-        printf ("%s(error) : addr = 0x%02X, reg = 0x%02X, size = %d\r\n", addr, reg, size);
+    if (gi->od == GPIO_OD_NATIVE) {
+        if (!port->ops->open_drain (port, mask, 0))
+            return -1;
+    } else if (gi->od == GPIO_OD_EMUL) {
+        /* input 인 상태에서 출력값을 high 로 바꾼 뒤 출력 전환 (low 가 출력되지 않도록) */
+        if (!port->ops->set_value (port, mask, mask))
+            return -1;
+        port->value |= mask;
+        if (!port->ops->direction (port, mask, mask))
+            return -1;
+        port->dir |= mask;
     }
-#endif
-    return i;
+    gi->od = GPIO_OD_NONE;
+    return 0;
 }
 
 //------------------------------------------------------------------------------
+// SCL line 을 delay 없이 toggle 하여 초당 edge 수를 측정함.
 //------------------------------------------------------------------------------
-int gpio_i2c_init (int scl_gpio, int sda_gpio)
+double gpio_i2c_bench (struct gpio_i2c *gi, int edges)
 {
-    if (!gpio_export (scl_gpio))    return -1;
-    if (!gpio_export (sda_gpio))    return -1;
+    struct timespec t_start, t_end;
+    double elapsed;
+    int i;
+
+    if ((gi == NULL) || (edges <= 0))
+        return -1;
 
-    GPIO_I2C_SCL = scl_gpio;
-    GPIO_I2C_SDA = sda_gpio;
-    gpio_direction (GPIO_I2C_SCL, GPIO_DIR_OUT);
-    gpio_direction (GPIO_I2C_SDA, GPIO_DIR_OUT);
-    gpio_i2c_stop  ();
+    clock_gettime (CLOCK_MONOTONIC, &t_start);
+    for (i = 0; i < edges; i++)
+        gpio_set_value (gi, GPIO_LINE_SCL, (i & 1) ? HIGH : LOW);
+    clock_gettime (CLOCK_MONOTONIC, &t_end);
 
-    return FD_GPIO_I2C;
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);
+
+    elapsed = (t_end.tv_sec  - t_start.tv_sec) +
+              (t_end.tv_nsec - t_start.tv_nsec) / 1000000000.0;
+
+    return elapsed > 0 ? edges / elapsed : 0;
 }
 
 //------------------------------------------------------------------------------
-void gpio_i2c_close (void)
+// 설정된 clock 으로 SCL 을 cycles 만큼 toggle 하여 실제 clock 과 jitter 를 측정.
+//------------------------------------------------------------------------------
+int gpio_i2c_selftest (struct gpio_i2c *gi, int cycles, struct gpio_i2c_clock_stat *stat)
 {
-    if (GPIO_I2C_SCL)   gpio_unexport (GPIO_I2C_SCL);
-    if (GPIO_I2C_SDA)   gpio_unexport (GPIO_I2C_SDA);
-    I2C_SLAVE_ADDR = 0;
+    struct gpio_delay_calib calib;
+    uint64_t *edge;
+    double sum = 0, sq = 0, half;
+    int i, edges = cycles * 2;
+
+    if ((gi == NULL) || (cycles <= 0) || (stat == NULL))
+        return -1;
+
+    if ((edge = malloc (sizeof(uint64_t) * (edges + 1))) == NULL)
+        return -1;
+
+    memset (stat, 0, sizeof(struct gpio_i2c_clock_stat));
+    gpio_delay_calib (&calib);
+
+    gi->deadline = 0;
+    i2c_delay (gi);
+    edge[0] = gpio_delay_now ();
+    for (i = 1; i <= edges; i++) {
+        gpio_set_value (gi, GPIO_LINE_SCL, (i & 1) ? LOW : HIGH);
+        i2c_delay (gi);
+        edge[i] = gpio_delay_now ();
+    }
+    gpio_set_value (gi, GPIO_LINE_SCL, HIGH);
+
+    stat->half_min_ns = stat->half_max_ns = (double)(edge[1] - edge[0]);
+    for (i = 1; i <= edges; i++) {
+        half = (double)(edge[i] - edge[i-1]);
+        sum += half;    sq += half * half;
+        if (half < stat->half_min_ns)   stat->half_min_ns = half;
+        if (half > stat->half_max_ns)   stat->half_max_ns = half;
+    }
+    stat->clock_hz       = gi->clock;
+    stat->cycles         = cycles;
+    stat->half_avg_ns    = sum / edges;
+    stat->jitter_ns      = sq / edges - stat->half_avg_ns * stat->half_avg_ns;
+    stat->jitter_ns      = stat->jitter_ns > 0 ? sqrt (stat->jitter_ns) : 0;
+    stat->achieved_hz    = 1000000000.0 * cycles / (double)(edge[edges] - edge[0]);
+    stat->sleep_slack_ns = calib.sleep_slack_ns;
+    stat->clock_cost_ns  = calib.clock_cost_ns;
+
+    free (edge);
+    return 0;
 }
 
 //------------------------------------------------------------------------------
-int gpio_i2c_ctrl (struct i2c_smbus_ioctl_data *args)
+// addr 은 7bit slave address. kernel 의 SMBus emulation 과 같이 message 로 변환하여 전송.
+// write 는 [command + data], read 는 [command] + repeated START + [data].
+//------------------------------------------------------------------------------
+int gpio_i2c_ctrl (struct gpio_i2c *gi, int addr, struct i2c_smbus_ioctl_data *args)
 {
-    int ret = 0;
+    union i2c_smbus_data *pdata = args->data;
+    uint8_t *buf = pdata ? pdata->block : NULL;
+    uint8_t wbuf[I2C_SMBUS_BLOCK_MAX + 2];
+    struct i2c_msg msg[2];
+    int len, ret;
 
-    if (!I2C_SLAVE_ADDR || (I2C_Mode != eI2C_MODE_GPIO))
+    if ((gi == NULL) || !addr)
         return -1;
 
+    msg[0].addr = msg[1].addr = addr;
+    msg[1].flags = I2C_M_RD;
+
     switch (args->size) {
-        case I2C_SMBUS_BYTE:        args->size = 0;     break;
-        case I2C_SMBUS_BYTE_DATA:   args->size = 1;     break;
-        case I2C_SMBUS_WORD_DATA:   args->size = 2;     break;
+        /* address 만 전송 (command/data 없음). address ACK 여부로 결과 반환 */
+        case I2C_SMBUS_QUICK:
+            msg[0].flags = args->read_write ? I2C_M_RD : 0;
+            msg[0].len   = 0;       msg[0].buf   = NULL;
+            return (gpio_i2c_transfer (gi, msg, 1) == 1) ? 0 : -1;
+        /* command 없이 1 byte read (receive byte) 또는 command 1 byte write (send byte) */
+        case I2C_SMBUS_BYTE:
+            if (args->read_write && (pdata == NULL))
+                return -1;
+            msg[0].flags = args->read_write ? I2C_M_RD : 0;
+            msg[0].len   = 1;
+            msg[0].buf   = args->read_write ? &pdata->byte : &args->command;
+            return (gpio_i2c_transfer (gi, msg, 1) == 1) ? 0 : -1;
+        case I2C_SMBUS_BYTE_DATA:   len = 1;    break;
+        case I2C_SMBUS_WORD_DATA:   len = 2;    break;
+        /* block[0] = count, block[1..] = data. write 는 count byte 도 전송 */
+        case I2C_SMBUS_BLOCK_DATA:
+            if (pdata == NULL)
+                return -1;
+            if (args->read_write) {
+                len = 1;
+                msg[1].flags |= I2C_M_RECV_LEN;
+            } else {
+                if (!pdata->block[0] || (pdata->block[0] > I2C_SMBUS_BLOCK_MAX))
+                    return -1;
+                len = pdata->block[0] + 1;
+            }
+            break;
+        /* block[0] = 읽거나 쓸 길이, block[1..] = data */
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+            if (pdata == NULL)
+                return -1;
+            if (!pdata->block[0] || (pdata->block[0] > I2C_SMBUS_BLOCK_MAX))
+                return -1;
+            len = pdata->block[0];
+            buf = &pdata->block[1];
+            break;
         default :
             return -1;
     }
+    if (buf == NULL)
+        return -1;
+
+    msg[0].flags = 0;
+    if (args->read_write) {
+        msg[0].len = 1;         msg[0].buf = &args->command;
+        msg[1].len = len;       msg[1].buf = buf;
+        ret = gpio_i2c_transfer (gi, msg, 2) == 2 ? 0 : -1;
+    } else {
+        wbuf[0] = args->command;
+        memcpy (&wbuf[1], buf, len);
+        msg[0].len = len + 1;   msg[0].buf = wbuf;
+        ret = gpio_i2c_transfer (gi, msg, 1) == 1 ? 0 : -1;
+    }
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// I2C_RDWR 와 동일한 combined transfer. 첫 message 는 START, 이후 message 는
+// repeated START (I2C_M_NOSTART 이면 생략) 로 이어지고 마지막에 한번만 STOP.
+// I2C_M_RECV_LEN 은 kernel 과 같이 msg->len 을 1 로 요청하면 count 만큼 늘어남.
+// 일반 transaction 은 compile 된 waveform (cache) 으로 실행하고, 길이가 data 에 따라
+// 바뀌는 I2C_M_RECV_LEN 만 edge 단위로 처리함. 성공시 전송한 message 수, 실패시 -1.
+//------------------------------------------------------------------------------
+int gpio_i2c_transfer (struct gpio_i2c *gi, struct i2c_msg *msgs, int nmsgs)
+{
+    const struct gpio_wave *wave;
+    int i, ret = -1;
+    uint16_t pos;
+
+    if (gi == NULL)
+        return -1;
+    if ((msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS))
+        return -1;
+
+    gi->timeout = 0;
+    /* open-drain 은 SDA 가 이미 release 상태이므로 read 1번으로 매 transaction 전에 확인 */
+    if (gi->od) {
+        int sda = 1;
+
+        gpio_get_value (gi, GPIO_LINE_SDA, &sda);
+        if (!sda && gpio_i2c_recover (gi))
+            return -1;
+    }
+
+    if ((wave = gpio_wave_get (&gi->wave, msgs, nmsgs)) != NULL) {
+        if (i2c_wave_run (gi, wave, gi->wave.sample)) {
+            /* timeout 이 아니면 NACK (errno 는 kernel i2c 와 같이 ENXIO) */
+            if (!gi->timeout)
+                errno = ENXIO;
+            return i2c_fail (gi);
+        }
+        gpio_wave_decode (wave, gi->wave.sample, msgs, nmsgs);
+        return nmsgs;
+    }
+
+    gpio_i2c_stop  (gi);
 
-    ret = args->read_write ? gpio_i2c_read (args) : gpio_i2c_write (args);
+    for (i = 0; i < nmsgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+        int rd = (msg->flags & I2C_M_RD) ? 1 : 0;
 
-    return ret ? 0 : -1;
+        /* 10bit address 는 지원하지 않음 */
+        if (msg->flags & I2C_M_TEN) {
+            errno = EOPNOTSUPP;
+            goto out;
+        }
+
+        if (!i || !(msg->flags & I2C_M_NOSTART)) {
+            gpio_i2c_start (gi, i ? 1 : 0);
+            if (i2c_write_bits (gi, (msg->addr << 1) | (rd ? I2C_READ_FLAG : 0)) &&
+                !(msg->flags & I2C_M_IGNORE_NAK)) {
+                errno = ENXIO;
+                goto out;
+            }
+        }
+
+        for (pos = 0; pos < msg->len; pos++) {
+            if (rd) {
+                msg->buf[pos] = i2c_read_bits (gi);
+                /* SMBus block read : 첫 byte 가 이후 data 의 count */
+                if ((msg->flags & I2C_M_RECV_LEN) && (pos == 0)) {
+                    if (!msg->buf[0] || (msg->buf[0] > I2C_SMBUS_BLOCK_MAX)) {
+                        i2c_send_ack (gi, 0);
+                        errno = EPROTO;
+                        goto out;
+                    }
+                    msg->len += msg->buf[0];
+                }
+                /* message 의 마지막 byte 는 NACK */
+                i2c_send_ack (gi, pos < (msg->len - 1));
+            }
+            else if (i2c_write_bits (gi, msg->buf[pos]) && !(msg->flags & I2C_M_IGNORE_NAK)) {
+                errno = ENXIO;
+                goto out;
+            }
+        }
+    }
+    ret = nmsgs;
+out:
+    gpio_i2c_stop  (gi);
+    if (gi->timeout) {
+        errno = ETIMEDOUT;
+        return i2c_fail (gi);
+    }
+    return (ret < 0) ? i2c_fail (gi) : ret;
+}
+
+//------------------------------------------------------------------------------
+// SCL 을 공유하는 SDA lane 들에 같은 구조의 combined transfer 를 lockstep 으로 실행.
+// msgs[lane] 은 lane 별 message 배열 (nmsgs 개). message 마다 flags, len 은 모든 lane 이 같아야
+// 하고 address 와 write data 는 lane 마다 다를 수 있음. read data 는 lane 별 buf 에 저장.
+// edge 마다 모든 lane 을 한번에 설정/sample 하므로 gpiochip, gpiomem transport 는
+// lane 수와 관계없이 edge 당 transport 호출 수가 같음.
+// lanes : 입력은 실행할 lane (bit n = lane n, 0 이면 모든 lane), 출력은 NACK 없이 끝난 lane.
+// NACK 한 lane 은 이후 SDA 를 release 하여 (START 도 보지 않음) 빠지고 마지막 STOP 만 받음.
+// I2C_M_RECV_LEN (lane 마다 길이가 다름) 과 10bit address 는 지원하지 않음 (EOPNOTSUPP).
+// 끝까지 진행한 lane 수 (모든 lane 이 NACK 이면 0, errno = ENXIO), 실패시 -1.
+//------------------------------------------------------------------------------
+int gpio_i2c_transfer_lanes (struct gpio_i2c *gi, struct i2c_msg **msgs, int nmsgs,
+                             uint32_t *lanes)
+{
+    struct gpio_port *port;
+    const struct i2c_msg *ref;
+    uint8_t data[GPIO_LANE_MAX];
+    uint32_t line, start, nack, value;
+    int i, lane, first, rd, ret;
+    uint16_t pos;
+
+    if ((gi == NULL) || (msgs == NULL) || (lanes == NULL))
+        return -1;
+    if ((nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS))
+        return -1;
+
+    port = &gi->port;
+    line = ((*lanes ? *lanes : ~0u) << GPIO_LINE_SDA) & gi->sda_mask;
+    if (!line) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (first = 0; !(line & GPIO_LINE_BIT(GPIO_LINE_SDA + first)); first++)
+        ;
+
+    /* lane 마다 clock 수가 같아야 함 (flags, len 이 첫 lane 과 같은지 확인) */
+    for (lane = 0; lane < gi->lanes; lane++) {
+        if (!(line & GPIO_LINE_BIT(GPIO_LINE_SDA + lane)))
+            continue;
+        for (i = 0; i < nmsgs; i++) {
+            ref = &msgs[first][i];
+            if (ref->flags & (I2C_M_TEN | I2C_M_RECV_LEN)) {
+                errno = EOPNOTSUPP;
+                return -1;
+            }
+            if ((msgs[lane][i].flags != ref->flags) || (msgs[lane][i].len != ref->len)) {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+    }
+
+    gi->timeout = 0;
+    /* open-drain : 잡혀 있는 SDA 가 있으면 recover, 그래도 잡혀 있는 lane 은 제외 */
+    if (gi->od && port->ops->get_value (port, line, &value) && ((value & line) != line)) {
+        gpio_i2c_recover (gi);
+        if (port->ops->get_value (port, line, &value))
+            line &= value;
+    }
+    start = line;
+
+    gpio_i2c_stop  (gi);
+
+    for (i = 0; (i < nmsgs) && line && !gi->timeout; i++) {
+        ref = &msgs[first][i];
+        rd  = (ref->flags & I2C_M_RD) ? 1 : 0;
+
+        if (!i || !(ref->flags & I2C_M_NOSTART)) {
+            lane_start (gi, line, i ? 1 : 0);
+            for (lane = 0; lane < gi->lanes; lane++)
+                if (line & GPIO_LINE_BIT(GPIO_LINE_SDA + lane))
+                    data[lane] = (msgs[lane][i].addr << 1) | (rd ? I2C_READ_FLAG : 0);
+            nack = lane_write_byte (gi, line, data);
+            if (!(ref->flags & I2C_M_IGNORE_NAK))
+                line &= ~nack;
+        }
+
+        for (pos = 0; (pos < ref->len) && line && !gi->timeout; pos++) {
+            if (rd) {
+                /* message 의 마지막 byte 는 NACK */
+                lane_read_byte (gi, line, data, (pos < (ref->len - 1)) ? line : 0);
+                for (lane = 0; lane < gi->lanes; lane++)
+                    if (line & GPIO_LINE_BIT(GPIO_LINE_SDA + lane))
+                        msgs[lane][i].buf[pos] = data[lane];
+                continue;
+            }
+            for (lane = 0; lane < gi->lanes; lane++)
+                if (line & GPIO_LINE_BIT(GPIO_LINE_SDA + lane))
+                    data[lane] = msgs[lane][i].buf[pos];
+            nack = lane_write_byte (gi, line, data);
+            if (!(ref->flags & I2C_M_IGNORE_NAK))
+                line &= ~nack;
+        }
+    }
+    lane_stop (gi);
+
+    if (gi->timeout) {
+        errno = ETIMEDOUT;
+        return i2c_fail (gi);
+    }
+
+    *lanes = line >> GPIO_LINE_SDA;
+    for (lane = 0, ret = 0; lane < gi->lanes; lane++)
+        if (line & GPIO_LINE_BIT(GPIO_LINE_SDA + lane))
+            ret++;
+
+    /* NACK 한 lane 이 있으면 (ENXIO) SDA 가 풀려 있는지 확인 */
+    if (line != start) {
+        errno = ENXIO;
+        i2c_fail (gi);
+    }
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int gpio_i2c_get_lanes (struct gpio_i2c *gi)
+{
+    return gi ? gi->lanes : 0;
 }
 
 //------------------------------------------------------------------------------
@@ -23,8 +23,49 @@
 #include <linux/i2c-dev.h>
 
 //------------------------------------------------------------------------------
-extern int gpio_i2c_init (int scl_gpio, int sda_gpio);
-extern int gpio_i2c_ctrl (struct i2c_smbus_ioctl_data *args);
+/* 기본 bus clock (기존 50us half period 와 동일) */
+#define GPIO_I2C_DEFAULT_CLK    10000
+/* open-drain mode 의 기본 clock stretching 제한 시간 (SMBus tTIMEOUT) */
+#define GPIO_I2C_STRETCH_US     25000
+
+struct gpio_i2c_clock_stat {
+    uint32_t    clock_hz;
+    int         cycles;
+    double      achieved_hz;
+    double      half_avg_ns;
+    double      half_min_ns;
+    double      half_max_ns;
+    /* half period 표준편차 */
+    double      jitter_ns;
+    uint32_t    sleep_slack_ns;
+    uint32_t    clock_cost_ns;
+};
+
+//------------------------------------------------------------------------------
+/* GPIO bus context (bus 마다 1개) */
+struct gpio_i2c;
+
+/* sda 는 lane 별 SDA 배열 (lanes 개, 1 ~ GPIO_LANE_MAX). SCL 은 모든 lane 이 공유 */
+extern struct gpio_i2c *gpio_i2c_init       (int scl_gpio, const int *sda_gpio, int lanes, int keep);
+extern struct gpio_i2c *gpio_i2c_init_chip  (const char *chip, int scl_offset,
+                                             const int *sda_offset, int lanes);
+extern struct gpio_i2c *gpio_i2c_init_mmap  (const char *board, const char *path,
+                                             int scl_gpio, const int *sda_gpio, int lanes);
+extern void     gpio_i2c_close      (struct gpio_i2c *gi);
+extern int      gpio_i2c_ctrl       (struct gpio_i2c *gi, int addr, struct i2c_smbus_ioctl_data *args);
+extern int      gpio_i2c_transfer   (struct gpio_i2c *gi, struct i2c_msg *msgs, int nmsgs);
+/* msgs[lane] 을 모든 lane 에 동시 전송. lanes 는 실행할/성공한 lane mask, 성공한 lane 수 반환 */
+extern int      gpio_i2c_transfer_lanes (struct gpio_i2c *gi, struct i2c_msg **msgs, int nmsgs,
+                                         uint32_t *lanes);
+extern int      gpio_i2c_get_lanes  (struct gpio_i2c *gi);
+extern double   gpio_i2c_bench      (struct gpio_i2c *gi, int edges);
+extern int      gpio_i2c_set_clock  (struct gpio_i2c *gi, uint32_t clock_hz);
+extern uint32_t gpio_i2c_get_clock  (struct gpio_i2c *gi);
+extern int      gpio_i2c_set_open_drain (struct gpio_i2c *gi, int enable, uint32_t stretch_us);
+/* SDA 가 잡혀 있으면 SCL pulse + STOP 으로 bus 복구. 실패한 transaction 후 자동으로 호출됨 */
+extern int      gpio_i2c_recover    (struct gpio_i2c *gi);
+extern uint32_t gpio_i2c_get_recover(struct gpio_i2c *gi);
+extern int      gpio_i2c_selftest   (struct gpio_i2c *gi, int cycles, struct gpio_i2c_clock_stat *stat);
 
 //------------------------------------------------------------------------------
 #endif  // __GPIO_I2C_H__
@@ -0,0 +1,345 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_mmap.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief GPIO memory mapped register(/dev/gpiomem) transport for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <ctype.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gpio_port.h"
+
+//------------------------------------------------------------------------------
+#define GPIO_MMAP_DEFAULT_PATH  "/dev/gpiomem"
+#define GPIO_MMAP_BLOCK_SIZE    4096
+/* bank register 의 read-modify-write 보호 lock 수 (bank 주소로 선택) */
+#define GPIO_MMAP_LOCK_MAX      8
+
+//------------------------------------------------------------------------------
+// Board 별 GPIO register 배치. offset 은 mapping 시작으로부터의 byte offset.
+// gpio 핀의 mux(function select)는 GPIO 로 설정되어 있어야 함. (kernel/dtb 설정)
+//------------------------------------------------------------------------------
+struct gpio_mmap_bank {
+    int         gpio_start;
+    int         gpio_end;
+    uint32_t    reg_dir;
+    uint32_t    reg_out;
+    uint32_t    reg_in;
+    /* 1 이면 dir register bit set = input (Amlogic OEN) */
+    int         dir_bit_in;
+};
+
+struct gpio_mmap_board {
+    const char  *name;
+    /* /dev/gpiomem, /dev/mem 에서의 mmap offset (일반 file 은 0 사용) */
+    off_t       base;
+    const struct gpio_mmap_bank *bank;
+    int         bank_cnt;
+};
+
+//------------------------------------------------------------------------------
+// ODROID-C4/HC4/N2 (Amlogic S905X3/S922X, GPIO base 410, register index * 4)
+//------------------------------------------------------------------------------
+static const struct gpio_mmap_bank amlogic_g12_bank[] = {
+    /* GPIOH */
+    { 427, 435, 0x119 << 2, 0x11A << 2, 0x11B << 2, 1 },
+    /* GPIOA */
+    { 460, 475, 0x120 << 2, 0x121 << 2, 0x122 << 2, 1 },
+    /* GPIOX */
+    { 476, 495, 0x116 << 2, 0x117 << 2, 0x118 << 2, 1 },
+};
+
+//------------------------------------------------------------------------------
+// Test layout : gpio 0 ~ 31, dir(0x00, 1 = out), out(0x04), in(0x08)
+// 일반 file 또는 /dev/shm 의 file 을 mapping 하여 test harness 에서 확인 가능.
+//------------------------------------------------------------------------------
+static const struct gpio_mmap_bank test_bank[] = {
+    {   0,  31, 0x00, 0x04, 0x08, 0 },
+};
+
+static const struct gpio_mmap_board gpio_mmap_boards[] = {
+    { "C4",     0xFF634000, amlogic_g12_bank, 3 },
+    { "HC4",    0xFF634000, amlogic_g12_bank, 3 },
+    { "N2",     0xFF634000, amlogic_g12_bank, 3 },
+    { "TEST",   0,          test_bank,        1 },
+};
+
+//------------------------------------------------------------------------------
+// 같은 bank 의 line 을 쓰는 bus 가 여러개면 (thread 별 bus) register read-modify-write 가
+// 서로의 edge 를 덮어쓸 수 있으므로 process 전체에서 bank 별 lock 으로 보호함.
+// bus 마다 mapping 주소가 다르므로 lock 은 board 의 물리 주소 (base + reg_out) 로 선택.
+//------------------------------------------------------------------------------
+static pthread_mutex_t  MMapLock[GPIO_MMAP_LOCK_MAX];
+static pthread_once_t   MMapLockOnce = PTHREAD_ONCE_INIT;
+
+struct gpio_mmap_line {
+    volatile uint32_t   *dir;
+    volatile uint32_t   *out;
+    volatile uint32_t   *in;
+    uint32_t            bit;
+    int                 dir_bit_in;
+    pthread_mutex_t     *lock;
+};
+
+struct gpio_mmap {
+    int         fd;
+    void        *map;
+    size_t      map_size;
+    struct gpio_mmap_line line[GPIO_LINE_MAX];
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static const struct gpio_mmap_board *gpio_mmap_board (const char *name);
+static int      mmap_line_setup (struct gpio_mmap *gm, const struct gpio_mmap_board *board,
+                                 struct gpio_mmap_line *line, int gpio);
+static void     mmap_lock_init  (void);
+
+static int      mmap_set_value  (struct gpio_port *port, uint32_t mask, uint32_t value);
+static int      mmap_get_value  (struct gpio_port *port, uint32_t mask, uint32_t *value);
+static int      mmap_direction  (struct gpio_port *port, uint32_t mask, uint32_t out);
+static void     mmap_close      (struct gpio_port *port);
+
+//------------------------------------------------------------------------------
+int gpio_mmap_open (struct gpio_port *port, const char *board,
+                    const char *path, const int *gpio, int lines);
+
+static const struct gpio_port_ops mmap_ops = {
+    .set_value  = mmap_set_value,
+    .get_value  = mmap_get_value,
+    .direction  = mmap_direction,
+    .close      = mmap_close,
+};
+
+//------------------------------------------------------------------------------
+static const struct gpio_mmap_board *gpio_mmap_board (const char *name)
+{
+    int i;
+
+    for (i = 0; i < (int)(sizeof(gpio_mmap_boards) / sizeof(gpio_mmap_boards[0])); i++)
+        if (!strcasecmp (name, gpio_mmap_boards[i].name))
+            return &gpio_mmap_boards[i];
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void mmap_lock_init (void)
+{
+    int i;
+
+    for (i = 0; i < GPIO_MMAP_LOCK_MAX; i++)
+        pthread_mutex_init (&MMapLock[i], NULL);
+}
+
+//------------------------------------------------------------------------------
+static int mmap_line_setup (struct gpio_mmap *gm, const struct gpio_mmap_board *board,
+                            struct gpio_mmap_line *line, int gpio)
+{
+    const struct gpio_mmap_bank *bank;
+    uint8_t *base = gm->map;
+    int i;
+
+    for (i = 0; i < board->bank_cnt; i++) {
+        bank = &board->bank[i];
+        if ((gpio < bank->gpio_start) || (gpio > bank->gpio_end))
+            continue;
+
+        if ((bank->reg_dir >= gm->map_size) || (bank->reg_out >= gm->map_size) ||
+            (bank->reg_in  >= gm->map_size))
+            break;
+
+        line->dir        = (volatile uint32_t *)(base + bank->reg_dir);
+        line->out        = (volatile uint32_t *)(base + bank->reg_out);
+        line->in         = (volatile uint32_t *)(base + bank->reg_in);
+        line->bit        = 1u << (gpio - bank->gpio_start);
+        line->dir_bit_in = bank->dir_bit_in;
+        line->lock       = &MMapLock[((board->base + bank->reg_out) >> 2) % GPIO_MMAP_LOCK_MAX];
+        return 1;
+    }
+    printf ("%s error : gpio = %d (board %s)\n", __func__, gpio, board->name);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 같은 register 에 속한 line 들은 한번의 read-modify-write (bank lock) 로 처리함.
+//------------------------------------------------------------------------------
+static int mmap_set_value (struct gpio_port *port, uint32_t mask, uint32_t value)
+{
+    struct gpio_mmap *gm = port->priv;
+    uint32_t done = 0, set, clr;
+    int i, j;
+
+    for (i = 0; i < port->lines; i++) {
+        volatile uint32_t *reg = gm->line[i].out;
+
+        if (!(mask & GPIO_LINE_BIT(i)) || (done & GPIO_LINE_BIT(i)))
+            continue;
+
+        for (j = i, set = 0, clr = 0; j < port->lines; j++) {
+            if (!(mask & GPIO_LINE_BIT(j)) || (gm->line[j].out != reg))
+                continue;
+            if (value & GPIO_LINE_BIT(j))   set |= gm->line[j].bit;
+            else                            clr |= gm->line[j].bit;
+            done |= GPIO_LINE_BIT(j);
+        }
+        pthread_mutex_lock   (gm->line[i].lock);
+        *reg = (*reg & ~clr) | set;
+        pthread_mutex_unlock (gm->line[i].lock);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int mmap_get_value (struct gpio_port *port, uint32_t mask, uint32_t *value)
+{
+    struct gpio_mmap *gm = port->priv;
+    int i;
+
+    for (i = 0, *value = 0; i < port->lines; i++) {
+        if (!(mask & GPIO_LINE_BIT(i)))
+            continue;
+        if (*gm->line[i].in & gm->line[i].bit)
+            *value |= GPIO_LINE_BIT(i);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// open-drain emulation 은 방향으로 출력하므로 set_value 와 같이 register 단위로 처리.
+//------------------------------------------------------------------------------
+static int mmap_direction (struct gpio_port *port, uint32_t mask, uint32_t out)
+{
+    struct gpio_mmap *gm = port->priv;
+    uint32_t done = 0, set, clr;
+    int i, j;
+
+    for (i = 0; i < port->lines; i++) {
+        volatile uint32_t *reg = gm->line[i].dir;
+
+        if (!(mask & GPIO_LINE_BIT(i)) || (done & GPIO_LINE_BIT(i)))
+            continue;
+
+        for (j = i, set = 0, clr = 0; j < port->lines; j++) {
+            struct gpio_mmap_line *line = &gm->line[j];
+
+            if (!(mask & GPIO_LINE_BIT(j)) || (line->dir != reg))
+                continue;
+            if ((out & GPIO_LINE_BIT(j)) ? !line->dir_bit_in : line->dir_bit_in)
+                set |= line->bit;
+            else
+                clr |= line->bit;
+            done |= GPIO_LINE_BIT(j);
+        }
+        pthread_mutex_lock   (gm->line[i].lock);
+        *reg = (*reg & ~clr) | set;
+        pthread_mutex_unlock (gm->line[i].lock);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void mmap_close (struct gpio_port *port)
+{
+    struct gpio_mmap *gm = port->priv;
+
+    if (gm == NULL)
+        return;
+
+    if (gm->map != MAP_FAILED)  munmap (gm->map, gm->map_size);
+    if (gm->fd >= 0)            close (gm->fd);
+    free (gm);
+    port->priv = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/* path 가 NULL 이면 /dev/gpiomem 사용. 일반 file 은 offset 0 부터 mapping. */
+//------------------------------------------------------------------------------
+int gpio_mmap_open (struct gpio_port *port, const char *board,
+                    const char *path, const int *gpio, int lines)
+{
+    const struct gpio_mmap_board *desc;
+    struct gpio_mmap *gm;
+    struct stat st;
+    off_t offset;
+    int i;
+
+    if ((lines <= 0) || (lines > GPIO_LINE_MAX) || (board == NULL))
+        return 0;
+
+    if ((desc = gpio_mmap_board (board)) == NULL) {
+        printf ("%s error : unknown board %s\n", __func__, board);
+        return 0;
+    }
+    if (path == NULL)
+        path = GPIO_MMAP_DEFAULT_PATH;
+
+    if ((gm = calloc (1, sizeof(struct gpio_mmap))) == NULL)
+        return 0;
+
+    pthread_once (&MMapLockOnce, mmap_lock_init);
+
+    gm->map      = MAP_FAILED;
+    gm->map_size = GPIO_MMAP_BLOCK_SIZE;
+    port->ops    = &mmap_ops;
+    port->lines  = lines;
+    port->priv   = gm;
+
+    if ((gm->fd = open (path, O_RDWR | O_SYNC | O_CLOEXEC)) < 0) {
+        printf ("%s error : Unable to open %s\n", __func__, path);
+        goto err_out;
+    }
+    if (fstat (gm->fd, &st) < 0)
+        goto err_out;
+
+    offset = desc->base;
+    if (S_ISREG (st.st_mode)) {
+        if (st.st_size < GPIO_MMAP_BLOCK_SIZE) {
+            printf ("%s error : %s is smaller than %d bytes\n",
+                __func__, path, GPIO_MMAP_BLOCK_SIZE);
+            goto err_out;
+        }
+        offset = 0;
+    }
+
+    gm->map = mmap (NULL, gm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, gm->fd, offset);
+    if (gm->map == MAP_FAILED) {
+        printf ("%s error : mmap failed (%s)\n", __func__, path);
+        goto err_out;
+    }
+
+    for (i = 0; i < lines; i++) {
+        port->gpio[i] = gpio[i];
+        if (!mmap_line_setup (gm, desc, &gm->line[i], gpio[i]))
+            goto err_out;
+    }
+    return 1;
+
+err_out:
+    mmap_close (port);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_port.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief GPIO line transport (sysfs / chardev / mmap) for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __GPIO_PORT_H__
+#define __GPIO_PORT_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// GPIO I2C 에서 사용하는 line index. 모든 transport 함수는 line bit mask 로 동작함.
+// multi-lane bus (SCL 1개 + SDA N개) 의 lane n 은 line GPIO_LINE_SDA + n.
+//------------------------------------------------------------------------------
+#define GPIO_LINE_SCL       0
+#define GPIO_LINE_SDA       1
+#define GPIO_LANE_MAX       8
+#define GPIO_LINE_MAX       (GPIO_LINE_SDA + GPIO_LANE_MAX)
+
+#define GPIO_LINE_BIT(x)    (1u << (x))
+
+struct gpio_port;
+
+struct gpio_port_ops {
+    /* mask 에 해당하는 line 의 출력값을 value bit 로 설정 (input line 은 출력 전환시 적용) */
+    int     (*set_value)    (struct gpio_port *port, uint32_t mask, uint32_t value);
+    /* mask 에 해당하는 line 의 입력값을 value 에 저장 */
+    int     (*get_value)    (struct gpio_port *port, uint32_t mask, uint32_t *value);
+    /* mask 에 해당하는 line 의 방향 설정 (bit 1 = out, 0 = in). 출력값은 port->value 유지 */
+    int     (*direction)    (struct gpio_port *port, uint32_t mask, uint32_t out);
+    /* (선택) mask 의 line 을 native open-drain 출력으로 설정/해제. 미지원 transport 는 NULL */
+    int     (*open_drain)   (struct gpio_port *port, uint32_t mask, int enable);
+    void    (*close)        (struct gpio_port *port);
+};
+
+struct gpio_port {
+    const struct gpio_port_ops *ops;
+    int         lines;
+    int         gpio[GPIO_LINE_MAX];
+    /* 마지막으로 설정된 출력값/방향 (bit 1 = high / out) */
+    uint32_t    value;
+    uint32_t    dir;
+    void        *priv;
+};
+
+//------------------------------------------------------------------------------
+/* keep : close 시 unexport 하지 않음 (이미 export 된 line 은 항상 재사용) */
+extern int  gpio_sysfs_open (struct gpio_port *port, const int *gpio, int lines, int keep);
+extern int  gpio_cdev_open  (struct gpio_port *port, const char *chip, const int *offset, int lines);
+extern int  gpio_mmap_open  (struct gpio_port *port, const char *board,
+                             const char *path, const int *gpio, int lines);
+
+//------------------------------------------------------------------------------
+#endif  // __GPIO_PORT_H__
+//------------------------------------------------------------------------------
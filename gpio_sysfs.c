@@ -0,0 +1,349 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_sysfs.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief GPIO sysfs(/sys/class/gpio) transport for GPIO I2C.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include "gpio_port.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+#if !defined(GPIO_CONTROL_PATH)
+    #define	GPIO_CONTROL_PATH   "/sys/class/gpio"
+#endif
+
+/* export 후 value/direction node 가 생기고 udev 가 권한을 설정할 때까지 기다리는 최대 시간 */
+#if !defined(GPIO_SYSFS_WAIT_MS)
+    #define GPIO_SYSFS_WAIT_MS  1000
+#endif
+/* sysfs 는 kernel 이 만든 node 의 생성 event 를 보내지 않으므로 inotify 대기 중에도 재시도 */
+#define GPIO_SYSFS_POLL_MS      5
+
+//------------------------------------------------------------------------------
+// sysfs value/direction 파일은 bus가 열려있는 동안 계속 open 상태로 유지함.
+// (edge 마다 fopen/fclose 하지 않고 offset 0 에서 pwrite/pread 사용)
+//------------------------------------------------------------------------------
+struct gpio_line {
+    int gpio;
+    int fd_value;
+    int fd_direction;
+    /* 이 process 가 export 한 line (다른 process 나 이전 실행이 export 한 line 은 재사용) */
+    int exported;
+};
+
+struct gpio_sysfs {
+    struct gpio_line line[GPIO_LINE_MAX];
+    /* close 시 unexport 하지 않음 (다음 실행은 export/udev 대기 없이 바로 open) */
+    int keep;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      gpio_write_ctrl (const char *ctrl, int gpio);
+static int      gpio_export     (int gpio);
+static int      gpio_unexport   (int gpio);
+static int      gpio_line_open  (struct gpio_line *line, int gpio);
+static int      gpio_line_wait  (struct gpio_line *line, int gpio);
+static void     gpio_line_close (struct gpio_line *line);
+
+static int      sysfs_set_value (struct gpio_port *port, uint32_t mask, uint32_t value);
+static int      sysfs_get_value (struct gpio_port *port, uint32_t mask, uint32_t *value);
+static int      sysfs_direction (struct gpio_port *port, uint32_t mask, uint32_t out);
+static void     sysfs_close     (struct gpio_port *port);
+
+//------------------------------------------------------------------------------
+int gpio_sysfs_open (struct gpio_port *port, const int *gpio, int lines, int keep);
+
+static const struct gpio_port_ops sysfs_ops = {
+    .set_value  = sysfs_set_value,
+    .get_value  = sysfs_get_value,
+    .direction  = sysfs_direction,
+    .close      = sysfs_close,
+};
+
+//------------------------------------------------------------------------------
+// export/unexport file 에 gpio 번호를 씀. 성공시 0, 실패시 errno.
+//------------------------------------------------------------------------------
+static int gpio_write_ctrl (const char *ctrl, int gpio)
+{
+    char fname[256], gpio_num[16];
+    int fd, len, err = 0;
+
+    memset (fname, 0x00, sizeof(fname));
+    sprintf (fname, "%s/%s", GPIO_CONTROL_PATH, ctrl);
+    if ((fd = open (fname, O_WRONLY | O_CLOEXEC)) < 0)
+        return errno;
+
+    len = snprintf (gpio_num, sizeof(gpio_num), "%d", gpio);
+    if (write (fd, gpio_num, len) != len)
+        err = errno;
+    close (fd);
+    return err;
+}
+
+//------------------------------------------------------------------------------
+// 이미 export 되어 있으면 (이전 실행의 keep, 다른 process) 그대로 사용.
+// 새로 export 하면 1, 이미 export 되어 있으면 0, 실패시 -1.
+//------------------------------------------------------------------------------
+static int gpio_export (int gpio)
+{
+    char fname[256];
+    int err;
+
+    memset (fname, 0x00, sizeof(fname));
+    sprintf (fname, "%s/gpio%d", GPIO_CONTROL_PATH, gpio);
+    if (!access (fname, F_OK))
+        return 0;
+
+    /* access 와 export 사이에 다른 process 가 export 한 경우 EBUSY */
+    if (!(err = gpio_write_ctrl ("export", gpio)))
+        return 1;
+    if (err == EBUSY)
+        return 0;
+
+    printf ("%s error : gpio = %d, %s\n", __func__, gpio, strerror (err));
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+static int gpio_unexport (int gpio)
+{
+    int err;
+
+    if (!(err = gpio_write_ctrl ("unexport", gpio)))
+        return 1;
+
+    printf ("%s error : gpio = %d, %s\n", __func__, gpio, strerror (err));
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 실패시 errno 유지 (ENOENT/EACCES 는 node 생성 또는 udev 권한 설정 전)
+//------------------------------------------------------------------------------
+static int gpio_line_open (struct gpio_line *line, int gpio)
+{
+    char fname[256];
+    int err;
+
+    memset (fname, 0x00, sizeof(fname));
+    sprintf (fname, "%s/gpio%d/direction", GPIO_CONTROL_PATH, gpio);
+    if ((line->fd_direction = open (fname, O_WRONLY | O_CLOEXEC)) < 0)
+        return 0;
+
+    memset (fname, 0x00, sizeof(fname));
+    sprintf (fname, "%s/gpio%d/value", GPIO_CONTROL_PATH, gpio);
+    if ((line->fd_value = open (fname, O_RDWR | O_CLOEXEC)) < 0) {
+        err = errno;
+        gpio_line_close (line);
+        errno = err;
+        return 0;
+    }
+
+    line->gpio = gpio;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// value/direction node 가 열릴 때까지 대기 (고정 sleep 대신 inotify).
+// gpioN directory 의 IN_ATTRIB (udev chmod/chown) 과 class directory 의 IN_CREATE 로
+// 바로 깨어나고, event 가 없는 경우를 위해 GPIO_SYSFS_POLL_MS 마다 재시도.
+//------------------------------------------------------------------------------
+static int gpio_line_wait (struct gpio_line *line, int gpio)
+{
+    char dname[256];
+    char event[sizeof(struct inotify_event) + 256];
+    uint64_t deadline;
+    struct pollfd pfd;
+    int wd = -1;
+
+    /* 이미 export 되어 권한까지 설정된 line 은 inotify 없이 바로 open */
+    if (gpio_line_open (line, gpio))
+        return 1;
+
+    memset (dname, 0x00, sizeof(dname));
+    sprintf (dname, "%s/gpio%d", GPIO_CONTROL_PATH, gpio);
+
+    /* inotify 를 사용할 수 없으면 poll 은 timeout 만큼 sleep 으로 동작 */
+    pfd.fd     = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    pfd.events = POLLIN;
+    if (pfd.fd >= 0)
+        inotify_add_watch (pfd.fd, GPIO_CONTROL_PATH, IN_CREATE);
+
+    deadline = gpio_delay_now () + (uint64_t)GPIO_SYSFS_WAIT_MS * 1000000;
+    while (1) {
+        if ((errno != ENOENT) && (errno != EACCES) && (errno != EPERM))
+            break;
+        if (gpio_delay_now () >= deadline) {
+            errno = ETIMEDOUT;
+            break;
+        }
+        if ((pfd.fd >= 0) && (wd < 0))
+            wd = inotify_add_watch (pfd.fd, dname, IN_ATTRIB | IN_CREATE);
+
+        if (poll (&pfd, 1, GPIO_SYSFS_POLL_MS) > 0)
+            while (read (pfd.fd, event, sizeof(event)) > 0)
+                ;
+        if (gpio_line_open (line, gpio)) {
+            if (pfd.fd >= 0)
+                close (pfd.fd);
+            return 1;
+        }
+    }
+    printf ("%s error : gpio = %d, %s\n", __func__, gpio, strerror (errno));
+    if (pfd.fd >= 0)
+        close (pfd.fd);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void gpio_line_close (struct gpio_line *line)
+{
+    if (line->fd_value     >= 0)    close (line->fd_value);
+    if (line->fd_direction >= 0)    close (line->fd_direction);
+
+    line->fd_value = line->fd_direction = -1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int sysfs_set_value (struct gpio_port *port, uint32_t mask, uint32_t value)
+{
+    struct gpio_sysfs *sysfs = port->priv;
+    int i;
+
+    for (i = 0; i < port->lines; i++) {
+        char c = (value & GPIO_LINE_BIT(i)) ? '1' : '0';
+
+        /* input line 의 value 는 쓸 수 없으므로 출력 전환시 (high/low) 적용 */
+        if (!(mask & port->dir & GPIO_LINE_BIT(i)))
+            continue;
+        if (pwrite (sysfs->line[i].fd_value, &c, 1, 0) != 1) {
+            printf ("%s error : gpio = %d\n", __func__, sysfs->line[i].gpio);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int sysfs_get_value (struct gpio_port *port, uint32_t mask, uint32_t *value)
+{
+    struct gpio_sysfs *sysfs = port->priv;
+    int i;
+
+    for (i = 0, *value = 0; i < port->lines; i++) {
+        char c;
+
+        if (!(mask & GPIO_LINE_BIT(i)))
+            continue;
+        if (pread (sysfs->line[i].fd_value, &c, 1, 0) != 1) {
+            printf ("%s error : gpio = %d\n", __func__, sysfs->line[i].gpio);
+            return 0;
+        }
+        if (c != '0')
+            *value |= GPIO_LINE_BIT(i);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 출력 전환은 "high"/"low" 로 방향과 출력값 (port->value) 을 한번에 설정 (glitch 방지).
+//------------------------------------------------------------------------------
+static int sysfs_direction (struct gpio_port *port, uint32_t mask, uint32_t out)
+{
+    struct gpio_sysfs *sysfs = port->priv;
+    int i;
+
+    for (i = 0; i < port->lines; i++) {
+        const char *gpio_status = !(out & GPIO_LINE_BIT(i)) ? "in" :
+                                  (port->value & GPIO_LINE_BIT(i)) ? "high" : "low";
+
+        if (!(mask & GPIO_LINE_BIT(i)))
+            continue;
+        if (pwrite (sysfs->line[i].fd_direction, gpio_status, strlen(gpio_status), 0) <= 0) {
+            printf ("%s error : gpio = %d\n", __func__, sysfs->line[i].gpio);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void sysfs_close (struct gpio_port *port)
+{
+    struct gpio_sysfs *sysfs = port->priv;
+    int i;
+
+    if (sysfs == NULL)
+        return;
+
+    for (i = 0; i < port->lines; i++) {
+        gpio_line_close (&sysfs->line[i]);
+        if (sysfs->line[i].exported && !sysfs->keep)
+            gpio_unexport (port->gpio[i]);
+    }
+    free (sysfs);
+    port->priv = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// keep : close 시 unexport 하지 않음. 이미 export 된 line 은 재사용하고 unexport 하지 않음.
+//------------------------------------------------------------------------------
+int gpio_sysfs_open (struct gpio_port *port, const int *gpio, int lines, int keep)
+{
+    struct gpio_sysfs *sysfs;
+    int i, ret;
+
+    if ((lines <= 0) || (lines > GPIO_LINE_MAX))
+        return 0;
+
+    if ((sysfs = calloc (1, sizeof(struct gpio_sysfs))) == NULL)
+        return 0;
+
+    for (i = 0; i < GPIO_LINE_MAX; i++)
+        sysfs->line[i].fd_value = sysfs->line[i].fd_direction = -1;
+
+    port->ops   = &sysfs_ops;
+    port->lines = lines;
+    port->priv  = sysfs;
+    port->value = GPIO_LINE_BIT(lines) - 1;
+    sysfs->keep = keep;
+
+    for (i = 0; i < lines; i++) {
+        port->gpio[i] = gpio[i];
+        if ((ret = gpio_export (gpio[i])) < 0) {
+            sysfs_close (port);
+            return 0;
+        }
+        sysfs->line[i].exported = ret;
+        if (!gpio_line_wait (&sysfs->line[i], gpio[i])) {
+            sysfs_close (port);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
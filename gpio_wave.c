@@ -0,0 +1,305 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_wave.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Precompiled GPIO I2C waveform (edge operation array) and cache.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "gpio_wave.h"
+
+//------------------------------------------------------------------------------
+// compile 은 같은 함수로 두번 실행 (op == NULL 이면 길이만 계산).
+//------------------------------------------------------------------------------
+struct wave_build {
+    uint8_t     *op;
+    int         len;
+    int         nsample;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static void     wave_emit       (struct wave_build *b, uint8_t op);
+static void     wave_start      (struct wave_build *b, int restart);
+static void     wave_stop       (struct wave_build *b);
+static void     wave_write_byte (struct wave_build *b, uint8_t wd, int ignore_nak);
+static void     wave_read_byte  (struct wave_build *b, int ack);
+static int      wave_build      (struct wave_build *b, struct gpio_wave *wave,
+                                 const struct i2c_msg *msgs, int nmsgs);
+static int      wave_key        (uint8_t *key, const struct i2c_msg *msgs, int nmsgs);
+
+//------------------------------------------------------------------------------
+int      gpio_wave_compile  (struct gpio_wave *wave, const struct i2c_msg *msgs, int nmsgs);
+void     gpio_wave_decode   (const struct gpio_wave *wave, const uint8_t *sample,
+                             struct i2c_msg *msgs, int nmsgs);
+const struct gpio_wave *gpio_wave_get (struct gpio_wave_cache *cache,
+                             const struct i2c_msg *msgs, int nmsgs);
+void     gpio_wave_cache_free (struct gpio_wave_cache *cache);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void wave_emit (struct wave_build *b, uint8_t op)
+{
+    if (b->op != NULL)
+        b->op[b->len] = op;
+    b->len++;
+}
+
+//------------------------------------------------------------------------------
+// 아래 edge 순서는 gpio_i2c.c 의 gpio_i2c_start/stop, i2c_write_bits,
+// i2c_read_bits, i2c_send_ack 와 동일함.
+//------------------------------------------------------------------------------
+static void wave_start (struct wave_build *b, int restart)
+{
+    wave_emit (b, eGPIO_WAVE_SDA_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    if (restart) {
+        wave_emit (b, eGPIO_WAVE_SDA_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+        wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+        wave_emit (b, eGPIO_WAVE_SDA_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+        wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void wave_stop (struct wave_build *b)
+{
+    wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SDA_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+}
+
+//------------------------------------------------------------------------------
+static void wave_write_byte (struct wave_build *b, uint8_t wd, int ignore_nak)
+{
+    int i;
+
+    for (i = 0; i < 8; i++, wd <<= 1) {
+        wave_emit (b, (wd & 0x80) ? eGPIO_WAVE_SDA_HI : eGPIO_WAVE_SDA_LO);
+        wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+        wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    }
+    wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SDA_IN);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, ignore_nak ? eGPIO_WAVE_ACK_IGN : eGPIO_WAVE_ACK);
+    wave_emit (b, eGPIO_WAVE_SDA_OUT);  wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    if (!ignore_nak)
+        wave_emit (b, eGPIO_WAVE_CHECK);
+}
+
+//------------------------------------------------------------------------------
+static void wave_read_byte (struct wave_build *b, int ack)
+{
+    int i;
+
+    wave_emit (b, eGPIO_WAVE_SDA_IN);
+    for (i = 0; i < 8; i++) {
+        wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+        wave_emit (b, eGPIO_WAVE_SAMPLE);
+        wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    }
+    b->nsample += 8;
+    wave_emit (b, eGPIO_WAVE_SDA_OUT);
+
+    wave_emit (b, ack ? eGPIO_WAVE_SDA_LO : eGPIO_WAVE_SDA_HI); wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SCL_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SCL_LO);   wave_emit (b, eGPIO_WAVE_DELAY);
+    wave_emit (b, eGPIO_WAVE_SDA_HI);   wave_emit (b, eGPIO_WAVE_DELAY);
+}
+
+//------------------------------------------------------------------------------
+// gpio_i2c_transfer 와 같은 순서 : STOP(idle), message 마다 (repeated) START + address + data,
+// 마지막 STOP. 길이가 data 에 따라 바뀌는 I2C_M_RECV_LEN 과 10bit address 는 compile 불가 (-1).
+//------------------------------------------------------------------------------
+static int wave_build (struct wave_build *b, struct gpio_wave *wave,
+                       const struct i2c_msg *msgs, int nmsgs)
+{
+    int i, pos, rd;
+
+    b->len = b->nsample = 0;
+    wave_stop (b);
+
+    for (i = 0; i < nmsgs; i++) {
+        const struct i2c_msg *msg = &msgs[i];
+
+        if (msg->flags & (I2C_M_TEN | I2C_M_RECV_LEN))
+            return -1;
+
+        rd = (msg->flags & I2C_M_RD) ? 1 : 0;
+        if (!i || !(msg->flags & I2C_M_NOSTART)) {
+            wave_start (b, i ? 1 : 0);
+            wave_write_byte (b, (msg->addr << 1) | rd, msg->flags & I2C_M_IGNORE_NAK);
+        }
+        wave->sample_pos[i] = rd ? b->nsample : -1;
+
+        for (pos = 0; pos < msg->len; pos++) {
+            if (rd)
+                wave_read_byte (b, pos < (msg->len - 1));
+            else
+                wave_write_byte (b, msg->buf[pos], msg->flags & I2C_M_IGNORE_NAK);
+        }
+    }
+    wave->stop = b->len;
+    wave_stop (b);
+    wave_emit (b, eGPIO_WAVE_END);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// message 마다 addr(1), flags(2), len(2) 와 write data. key 보다 크면 -1 (cache 안함).
+//------------------------------------------------------------------------------
+static int wave_key (uint8_t *key, const struct i2c_msg *msgs, int nmsgs)
+{
+    int i, len = 0;
+
+    for (i = 0; i < nmsgs; i++) {
+        const struct i2c_msg *msg = &msgs[i];
+        int wlen = (msg->flags & I2C_M_RD) ? 0 : msg->len;
+
+        if (len + 5 + wlen > GPIO_WAVE_KEY_MAX)
+            return -1;
+
+        key[len++] = msg->addr;
+        key[len++] = msg->flags & 0xFF;
+        key[len++] = msg->flags >> 8;
+        key[len++] = msg->len & 0xFF;
+        key[len++] = msg->len >> 8;
+        memcpy (&key[len], msg->buf, wlen);
+        len += wlen;
+    }
+    return len;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// msgs 를 wave->op 로 compile (기존 op 는 해제). 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int gpio_wave_compile (struct gpio_wave *wave, const struct i2c_msg *msgs, int nmsgs)
+{
+    struct wave_build b = { NULL, 0, 0 };
+
+    if ((wave == NULL) || (msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS))
+        return -1;
+
+    free (wave->op);
+    wave->op  = NULL;
+    wave->len = 0;
+
+    if (wave_build (&b, wave, msgs, nmsgs))
+        return -1;
+
+    if ((b.op = malloc (b.len)) == NULL)
+        return -1;
+
+    wave_build (&b, wave, msgs, nmsgs);
+    wave->op      = b.op;
+    wave->len     = b.len;
+    wave->nsample = b.nsample;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 실행 후 sample (bit 당 1 byte, MSB first) 을 read message 의 buf 에 채움.
+//------------------------------------------------------------------------------
+void gpio_wave_decode (const struct gpio_wave *wave, const uint8_t *sample,
+                       struct i2c_msg *msgs, int nmsgs)
+{
+    const uint8_t *s;
+    int i, pos, bit;
+    uint8_t rd;
+
+    for (i = 0; i < nmsgs; i++) {
+        if (wave->sample_pos[i] < 0)
+            continue;
+
+        s = &sample[wave->sample_pos[i]];
+        for (pos = 0; pos < msgs[i].len; pos++) {
+            for (bit = 0, rd = 0; bit < 8; bit++)
+                rd = (rd << 1) | *s++;
+            msgs[i].buf[pos] = rd;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// 같은 transaction (address, flags, 길이, write data) 은 cache 된 waveform 을 사용.
+// cache 가 가득 차면 가장 오래 사용하지 않은 것을 교체. 큰 transaction 은 scratch 에 compile.
+// cache->sample 은 반환된 waveform 의 nsample 이상으로 준비됨. compile 불가시 NULL.
+// compile 할 수 없는 transaction (I2C_M_RECV_LEN, 10bit) 은 cache entry 를 교체하기 전에 거름.
+//------------------------------------------------------------------------------
+const struct gpio_wave *gpio_wave_get (struct gpio_wave_cache *cache,
+                                       const struct i2c_msg *msgs, int nmsgs)
+{
+    struct gpio_wave *wave = NULL;
+    uint8_t key[GPIO_WAVE_KEY_MAX];
+    uint8_t *sample;
+    int i, key_len;
+
+    if ((msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS))
+        return NULL;
+
+    for (i = 0; i < nmsgs; i++)
+        if (msgs[i].flags & (I2C_M_TEN | I2C_M_RECV_LEN))
+            return NULL;
+
+    if ((key_len = wave_key (key, msgs, nmsgs)) > 0) {
+        for (i = 0; i < GPIO_WAVE_CACHE_MAX; i++) {
+            struct gpio_wave *e = &cache->entry[i];
+
+            if ((e->key_len == key_len) && !memcmp (e->key, key, key_len)) {
+                e->stamp = ++cache->stamp;
+                cache->hit++;
+                return e;
+            }
+            if ((wave == NULL) || (e->stamp < wave->stamp))
+                wave = e;
+        }
+    } else
+        wave = &cache->scratch;
+
+    cache->miss++;
+    wave->key_len = 0;
+    if (gpio_wave_compile (wave, msgs, nmsgs))
+        return NULL;
+
+    if (wave->nsample > cache->sample_max) {
+        if ((sample = realloc (cache->sample, wave->nsample)) == NULL)
+            return NULL;
+        cache->sample     = sample;
+        cache->sample_max = wave->nsample;
+    }
+    if (key_len > 0) {
+        memcpy (wave->key, key, key_len);
+        wave->key_len = key_len;
+        wave->stamp   = ++cache->stamp;
+    }
+    return wave;
+}
+
+//------------------------------------------------------------------------------
+void gpio_wave_cache_free (struct gpio_wave_cache *cache)
+{
+    int i;
+
+    for (i = 0; i < GPIO_WAVE_CACHE_MAX; i++)
+        free (cache->entry[i].op);
+    free (cache->scratch.op);
+    free (cache->sample);
+    memset (cache, 0, sizeof(struct gpio_wave_cache));
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
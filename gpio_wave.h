@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/**
+ * @file gpio_wave.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Precompiled GPIO I2C waveform (edge operation array) and cache.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __GPIO_WAVE_H__
+#define __GPIO_WAVE_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+//------------------------------------------------------------------------------
+// transaction 1개를 edge 단위 동작 배열로 변환한 것. delay 는 half period 단위이므로
+// clock 을 바꿔도 다시 compile 할 필요 없음.
+//------------------------------------------------------------------------------
+enum {
+    eGPIO_WAVE_END = 0,
+    eGPIO_WAVE_SCL_LO,
+    eGPIO_WAVE_SCL_HI,
+    eGPIO_WAVE_SDA_LO,
+    eGPIO_WAVE_SDA_HI,
+    eGPIO_WAVE_SDA_IN,
+    eGPIO_WAVE_SDA_OUT,
+    /* half period 대기 */
+    eGPIO_WAVE_DELAY,
+    /* SDA 를 읽어 sample 배열에 저장 (read data bit) */
+    eGPIO_WAVE_SAMPLE,
+    /* SDA 를 읽어 NACK 여부 저장 */
+    eGPIO_WAVE_ACK,
+    /* SDA 를 읽지만 NACK 을 무시 (I2C_M_IGNORE_NAK) */
+    eGPIO_WAVE_ACK_IGN,
+    /* ACK clock 종료 후 NACK 이었으면 stop 위치로 이동 (transaction 실패) */
+    eGPIO_WAVE_CHECK,
+};
+
+/* 이 크기 이하의 transaction (message header 5 byte + write data) 만 cache 됨 */
+#define GPIO_WAVE_KEY_MAX       64
+#define GPIO_WAVE_CACHE_MAX     8
+
+struct gpio_wave {
+    uint8_t     *op;
+    int         len;
+    /* 마지막 STOP 조건의 시작 위치 (NACK 시 이동) */
+    int         stop;
+    int         nsample;
+    /* read message 의 첫 data bit 의 sample 위치 (write message 는 -1) */
+    int         sample_pos[I2C_RDWR_IOCTL_MAX_MSGS];
+
+    uint8_t     key[GPIO_WAVE_KEY_MAX];
+    int         key_len;
+    uint32_t    stamp;
+};
+
+struct gpio_wave_cache {
+    struct gpio_wave    entry[GPIO_WAVE_CACHE_MAX];
+    /* cache 하지 않는 (큰) transaction 용 */
+    struct gpio_wave    scratch;
+    uint32_t            stamp;
+    /* 실행 중 읽은 bit (1 byte = 1 bit), 가장 큰 nsample 크기로 유지 */
+    uint8_t             *sample;
+    int                 sample_max;
+    uint32_t            hit;
+    uint32_t            miss;
+};
+
+//------------------------------------------------------------------------------
+extern int      gpio_wave_compile   (struct gpio_wave *wave, const struct i2c_msg *msgs, int nmsgs);
+extern void     gpio_wave_decode    (const struct gpio_wave *wave, const uint8_t *sample,
+                                     struct i2c_msg *msgs, int nmsgs);
+extern const struct gpio_wave *gpio_wave_get (struct gpio_wave_cache *cache,
+                                     const struct i2c_msg *msgs, int nmsgs);
+extern void     gpio_wave_cache_free(struct gpio_wave_cache *cache);
+
+//------------------------------------------------------------------------------
+#endif  // __GPIO_WAVE_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
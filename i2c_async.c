@@ -0,0 +1,306 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_async.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Asynchronous per-bus request queue (worker thread, eventfd completion).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+#include "lib_i2c.h"
+#include "i2c_async.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+// Lock-free MPSC queue (intrusive, Vyukov). push 는 여러 thread 에서 동시에 가능하고
+// pop 은 한 thread 에서만 호출. stub node 로 항상 비어있지 않은 list 를 유지함.
+//------------------------------------------------------------------------------
+struct mpsc_queue {
+    struct i2c_async_req *_Atomic   head;
+    struct i2c_async_req            *tail;
+    struct i2c_async_req            stub;
+};
+
+//------------------------------------------------------------------------------
+// bus 마다 1개. 요청 queue 는 application thread -> worker,
+// 완료 queue 는 worker -> i2c_async_reap 호출 thread.
+//------------------------------------------------------------------------------
+struct i2c_async {
+    struct i2c_bus      *bus;
+    pthread_t           thread;
+    struct mpsc_queue   req_q;
+    struct mpsc_queue   done_q;
+    /* worker 깨우기 용 (worker 가 잠들어 있을 때만 write) */
+    int                 fd_doorbell;
+    atomic_int          sleeping;
+    atomic_int          stop;
+    /* 완료 알림 (epoll 용, 완료 queue 에 넣은 요청 수 만큼 증가) */
+    int                 fd_event;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static void     mpsc_init       (struct mpsc_queue *q);
+static void     mpsc_push       (struct mpsc_queue *q, struct i2c_async_req *req);
+static struct i2c_async_req *mpsc_pop (struct mpsc_queue *q);
+static int      mpsc_empty      (struct mpsc_queue *q);
+
+static void     async_process   (struct i2c_bus *bus, struct i2c_async_req *req);
+static void     async_wait      (struct i2c_async *as);
+static void     *async_worker   (void *arg);
+
+//------------------------------------------------------------------------------
+int  i2c_async_start    (int fd);
+int  i2c_async_submit   (int fd, struct i2c_async_req *req);
+struct i2c_async_req *i2c_async_reap (int fd);
+int  i2c_async_stop     (int fd);
+void i2c_async_free     (struct i2c_bus *bus);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void mpsc_init (struct mpsc_queue *q)
+{
+    atomic_store (&q->stub.next, NULL);
+    atomic_store (&q->head, &q->stub);
+    q->tail = &q->stub;
+}
+
+//------------------------------------------------------------------------------
+static void mpsc_push (struct mpsc_queue *q, struct i2c_async_req *req)
+{
+    struct i2c_async_req *prev;
+
+    atomic_store (&req->next, NULL);
+    prev = atomic_exchange (&q->head, req);
+    atomic_store (&prev->next, req);
+}
+
+//------------------------------------------------------------------------------
+// 비어있거나 push 가 진행중(head 는 바뀌었지만 link 전)이면 NULL.
+//------------------------------------------------------------------------------
+static struct i2c_async_req *mpsc_pop (struct mpsc_queue *q)
+{
+    struct i2c_async_req *tail = q->tail;
+    struct i2c_async_req *next = atomic_load (&tail->next);
+
+    if (tail == &q->stub) {
+        if (next == NULL)
+            return NULL;
+        q->tail = tail = next;
+        next = atomic_load (&tail->next);
+    }
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    if (tail != atomic_load (&q->head))
+        return NULL;
+
+    /* 마지막 node 를 꺼내기 위해 stub 을 다시 넣음 */
+    mpsc_push (q, &q->stub);
+    if ((next = atomic_load (&tail->next)) != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int mpsc_empty (struct mpsc_queue *q)
+{
+    return (q->tail == &q->stub) && (atomic_load (&q->head) == &q->stub);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void async_process (struct i2c_bus *bus, struct i2c_async_req *req)
+{
+    errno = 0;
+    switch (req->type) {
+        case eI2C_ASYNC_SMBUS:
+            req->ret = bus->ops->set_addr (bus, req->addr);
+            if (!req->ret)
+                req->ret = i2c_bus_smbus (bus, req->rw, req->command, req->size, &req->data);
+            break;
+        case eI2C_ASYNC_TRANSFER:
+            req->ret = i2c_bus_transfer (bus, req->msgs, req->nmsgs);
+            break;
+        default:
+            errno    = EINVAL;
+            req->ret = -1;
+            break;
+    }
+    req->err = (req->ret < 0) ? (errno ? errno : EIO) : 0;
+}
+
+//------------------------------------------------------------------------------
+// sleeping 을 먼저 표시한 후 queue 를 다시 확인하므로 submit 과 경쟁해도 깨우기를 놓치지 않음.
+//------------------------------------------------------------------------------
+static void async_wait (struct i2c_async *as)
+{
+    uint64_t cnt;
+
+    atomic_store (&as->sleeping, 1);
+    if (!mpsc_empty (&as->req_q) || atomic_load (&as->stop)) {
+        atomic_store (&as->sleeping, 0);
+        return;
+    }
+    if (read (as->fd_doorbell, &cnt, sizeof(cnt)) < 0)
+        atomic_store (&as->sleeping, 0);
+}
+
+//------------------------------------------------------------------------------
+static void *async_worker (void *arg)
+{
+    struct i2c_async *as = arg;
+    struct i2c_async_req *req;
+    uint64_t one = 1;
+
+    while (1) {
+        if ((req = mpsc_pop (&as->req_q)) == NULL) {
+            if (atomic_load (&as->stop) && mpsc_empty (&as->req_q))
+                break;
+            async_wait (as);
+            continue;
+        }
+        async_process (as->bus, req);
+
+        if (req->complete)
+            req->complete (req);
+        else {
+            mpsc_push (&as->done_q, req);
+            if (write (as->fd_event, &one, sizeof(one)) < 0)
+                fprintf (stderr, "%s : eventfd write error\n", __func__);
+        }
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// worker thread 시작. 성공시 완료 알림용 eventfd (epoll 가능), 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_async_start (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_async *as;
+
+    if (bus == NULL)
+        return -1;
+    if (bus->async != NULL)
+        return bus->async->fd_event;
+
+    if ((as = calloc (1, sizeof(struct i2c_async))) == NULL)
+        return -1;
+
+    as->bus = bus;
+    mpsc_init (&as->req_q);
+    mpsc_init (&as->done_q);
+    as->fd_doorbell = eventfd (0, EFD_CLOEXEC);
+    as->fd_event    = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ((as->fd_doorbell < 0) || (as->fd_event < 0))
+        goto err_out;
+
+    if (pthread_create (&as->thread, NULL, async_worker, as)) {
+        fprintf (stderr, "%s : worker thread create error\n", __func__);
+        goto err_out;
+    }
+    bus->async = as;
+    return as->fd_event;
+
+err_out:
+    if (as->fd_doorbell >= 0)   close (as->fd_doorbell);
+    if (as->fd_event >= 0)      close (as->fd_event);
+    free (as);
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// 여러 thread 에서 동시에 호출 가능 (lock 없음). 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_async_submit (int fd, struct i2c_async_req *req)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_async *as;
+    uint64_t one = 1;
+
+    if ((bus == NULL) || ((as = bus->async) == NULL) || (req == NULL))
+        return -1;
+    if (atomic_load (&as->stop))
+        return -1;
+
+    mpsc_push (&as->req_q, req);
+    if (atomic_exchange (&as->sleeping, 0)) {
+        if (write (as->fd_doorbell, &one, sizeof(one)) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// complete callback 이 없는 완료 요청을 하나 꺼냄 (없으면 NULL).
+// 한 thread 에서만 호출해야 함. eventfd 의 count 는 호출자가 read 로 비움.
+//------------------------------------------------------------------------------
+struct i2c_async_req *i2c_async_reap (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->async == NULL))
+        return NULL;
+
+    return mpsc_pop (&bus->async->done_q);
+}
+
+//------------------------------------------------------------------------------
+// 남은 요청을 모두 처리한 후 worker 종료. submit 하는 thread 가 모두 끝난 후 호출.
+// 완료 queue 의 요청은 더 이상 꺼낼 수 없으므로 stop 전에 reap 해야 함. 성공시 0.
+//------------------------------------------------------------------------------
+int i2c_async_stop (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->async == NULL))
+        return -1;
+
+    i2c_async_free (bus);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void i2c_async_free (struct i2c_bus *bus)
+{
+    struct i2c_async *as = bus->async;
+    uint64_t one = 1;
+
+    if (as == NULL)
+        return;
+
+    atomic_store (&as->stop, 1);
+    if (write (as->fd_doorbell, &one, sizeof(one)) < 0)
+        fprintf (stderr, "%s : eventfd write error\n", __func__);
+    pthread_join (as->thread, NULL);
+
+    close (as->fd_doorbell);
+    close (as->fd_event);
+    free (as);
+    bus->async = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
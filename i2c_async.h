@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_async.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Asynchronous per-bus request queue (worker thread, eventfd completion).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_ASYNC_H__
+#define __I2C_ASYNC_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+//------------------------------------------------------------------------------
+enum {
+    eI2C_ASYNC_SMBUS = 0,
+    eI2C_ASYNC_TRANSFER,
+    eI2C_ASYNC_END
+};
+
+//------------------------------------------------------------------------------
+// 요청은 완료될 때까지 호출자가 유지해야 함 (library 는 복사하지 않음).
+// complete 가 있으면 worker thread 에서 호출되고, 없으면 completion queue 에
+// 넣은 후 eventfd 를 증가시킴 (i2c_async_reap 으로 꺼냄).
+//------------------------------------------------------------------------------
+struct i2c_async_req {
+    int                 type;
+    /* 7bit slave address */
+    int                 addr;
+    /* eI2C_ASYNC_SMBUS : i2c_smbus_access 와 같은 인자 */
+    char                rw;
+    uint8_t             command;
+    int                 size;
+    union i2c_smbus_data data;
+    /* eI2C_ASYNC_TRANSFER : i2c_transfer 와 같은 인자 */
+    struct i2c_msg      *msgs;
+    int                 nmsgs;
+
+    void                (*complete) (struct i2c_async_req *req);
+    void                *arg;
+
+    /* 결과 : smbus 는 0/-1, transfer 는 message 수/-1. 실패시 err = errno */
+    int                 ret;
+    int                 err;
+
+    /* library 내부 사용 */
+    struct i2c_async_req *_Atomic next;
+};
+
+//------------------------------------------------------------------------------
+// i2c_async_start 후에는 worker thread 가 bus 를 사용하므로 같은 fd 로
+// 동기 함수를 호출하면 안됨. i2c_async_stop (또는 i2c_close) 은 남은 요청을 처리 후 종료.
+//------------------------------------------------------------------------------
+extern int  i2c_async_start     (int fd);
+extern int  i2c_async_submit    (int fd, struct i2c_async_req *req);
+extern struct i2c_async_req *i2c_async_reap (int fd);
+extern int  i2c_async_stop      (int fd);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_ASYNC_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
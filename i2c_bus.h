@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_bus.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief I2C bus handle (library internal) for ODROID-JIG.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_BUS_H__
+#define __I2C_BUS_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "lib_i2c.h"
+
+//------------------------------------------------------------------------------
+// fd 를 index 로 사용하는 handle table 크기.
+//------------------------------------------------------------------------------
+#define I2C_BUS_FD_MAX      1024
+
+/* 7bit slave address 수 (address 별 register cache table 크기) */
+#define I2C_BUS_ADDR_MAX    128
+
+struct i2c_cache;
+struct i2c_async;
+struct i2c_wc;
+struct i2c_stat;
+struct i2c_retry;
+
+//------------------------------------------------------------------------------
+// backend (HW, GPIO ...) 별 함수 table.
+//------------------------------------------------------------------------------
+struct i2c_bus_ops {
+    int     (*set_addr)     (struct i2c_bus *bus, int device_addr);
+    int     (*smbus)        (struct i2c_bus *bus, char rw, uint8_t command,
+                             int size, union i2c_smbus_data *data);
+    int     (*transfer)     (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+    int     (*set_clock)    (struct i2c_bus *bus, int clock_hz);
+    /* slave address 를 device_addr 로 바꾸고 ACK 확인. 응답하면 0, 없으면 -1 */
+    int     (*probe)        (struct i2c_bus *bus, int device_addr);
+    /* (선택) SDA 가 잡힌 bus 복구. 복구되었거나 free 이면 0 */
+    int     (*recover)      (struct i2c_bus *bus);
+    void    (*close)        (struct i2c_bus *bus);
+};
+
+struct i2c_bus {
+    const struct i2c_bus_ops *ops;
+    /* i2c_open 이 돌려주는 fd (GPIO bus 는 fd 번호 예약용 /dev/null) */
+    int     fd;
+    int     mode;
+    /* 7bit slave address (i2c_set_addr) */
+    int     addr;
+    /* adapter 기능 (I2C_FUNCS). GPIO bus 는 지원하는 SMBus 기능 */
+    unsigned long funcs;
+    /* backend context (GPIO : struct gpio_i2c) */
+    void    *priv;
+    /* slave address 별 register cache (i2c_cache_attach 된 device 만) */
+    struct i2c_cache *cache[I2C_BUS_ADDR_MAX];
+    /* i2c_async_start 후 bus 를 사용하는 worker (i2c_async.c) */
+    struct i2c_async *async;
+    /* i2c_wc_start 후 쓰기 대기중인 register 값 (i2c_wc.c) */
+    struct i2c_wc   *wc;
+    /* i2c_retry_set 으로 설정된 retry policy (i2c_retry.c) */
+    struct i2c_retry *retry;
+#if !defined (__LIB_I2C_NO_STAT__)
+    /* transaction counter / latency histogram (i2c_stat.c) */
+    struct i2c_stat *stat;
+#endif
+};
+
+//------------------------------------------------------------------------------
+// register cache (i2c_cache.c). bus->addr 의 cache 를 사용하며 cache 가 없으면
+// get 은 0(miss), put/drop 은 아무 동작 안함. get 은 hit 이면 1.
+// get/put 은 byte 단위 (8bit register), get_word/put_word 는 word (i2c_read/write_word).
+//------------------------------------------------------------------------------
+extern int  i2c_cache_get   (struct i2c_bus *bus, int reg, uint8_t *val, int len);
+extern void i2c_cache_put   (struct i2c_bus *bus, int reg, const uint8_t *val, int len);
+extern int  i2c_cache_get_word (struct i2c_bus *bus, int reg, uint8_t *val);
+extern void i2c_cache_put_word (struct i2c_bus *bus, int reg, const uint8_t *val);
+extern void i2c_cache_drop  (struct i2c_bus *bus, int reg, int len);
+extern void i2c_cache_free  (struct i2c_bus *bus);
+
+/* worker 가 있으면 남은 요청 처리 후 종료 (i2c_bus_close 에서 호출) */
+extern void i2c_async_free  (struct i2c_bus *bus);
+
+//------------------------------------------------------------------------------
+// write combining (i2c_wc.c). put 은 buffer 에 넣었으면 1, get 은 쓰기 대기중인 값이면 1.
+// flush_bus 는 다른 transaction 전에 호출 (대기중인 값이 없으면 바로 0).
+//------------------------------------------------------------------------------
+extern int  i2c_wc_put      (struct i2c_bus *bus, int reg, uint8_t val);
+extern int  i2c_wc_get      (struct i2c_bus *bus, int reg, uint8_t *val);
+extern int  i2c_wc_flush_bus(struct i2c_bus *bus);
+extern void i2c_wc_free     (struct i2c_bus *bus);
+
+//------------------------------------------------------------------------------
+// retry policy (i2c_retry.c). policy 는 addr 에 적용할 policy (없으면 NULL),
+// next 는 실패한 시도 후 다시 시도할지 결정 (backoff 대기 후 1).
+//------------------------------------------------------------------------------
+extern const struct i2c_retry_policy *i2c_retry_policy (struct i2c_bus *bus, int addr);
+extern int  i2c_retry_next  (struct i2c_bus *bus, const struct i2c_retry_policy *policy,
+                             int addr, int attempt);
+extern void i2c_retry_free  (struct i2c_bus *bus);
+
+//------------------------------------------------------------------------------
+// 통계 (i2c_stat.c). __LIB_I2C_NO_STAT__ build 에서는 아무 동작 안함.
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_STAT__)
+extern int  i2c_stat_alloc  (struct i2c_bus *bus);
+extern void i2c_stat_free   (struct i2c_bus *bus);
+extern void i2c_stat_record (struct i2c_bus *bus, int addr, uint64_t ns, int bytes, int ret);
+extern void i2c_stat_retry  (struct i2c_bus *bus, int addr);
+#else
+#define i2c_stat_alloc(bus)                         (0)
+#define i2c_stat_free(bus)                          do {} while (0)
+#define i2c_stat_record(bus, addr, ns, len, ret)    do {} while (0)
+#define i2c_stat_retry(bus, addr)                   do { (void)(bus); (void)(addr); } while (0)
+#endif
+
+//------------------------------------------------------------------------------
+// transaction trace (i2c_trace.c). 모든 bus 가 공유하는 전역 ring buffer 에 기록.
+// __LIB_I2C_NO_TRACE__ build 에서는 아무 동작 안함.
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_TRACE__)
+extern void i2c_trace_smbus     (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, char rw,
+                                 uint8_t command, int size, const union i2c_smbus_data *data, int ret);
+extern void i2c_trace_transfer  (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns,
+                                 const struct i2c_msg *msgs, int nmsgs, int ret);
+extern void i2c_trace_probe     (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, int addr, int ret);
+#else
+#define i2c_trace_smbus(bus, start, ns, rw, cmd, size, data, ret)   do {} while (0)
+#define i2c_trace_transfer(bus, start, ns, msgs, nmsgs, ret)        do {} while (0)
+#define i2c_trace_probe(bus, start, ns, addr, ret)                  do {} while (0)
+#endif
+
+//------------------------------------------------------------------------------
+// backend 호출 hook (lib_i2c.c). backend 의 smbus/transfer/probe 는 직접 호출하지 말고
+// i2c_bus_* 를 사용할 것 (retry policy 적용, 통계/trace 기록).
+//------------------------------------------------------------------------------
+extern int  i2c_bus_smbus   (struct i2c_bus *bus, char rw, uint8_t command,
+                             int size, union i2c_smbus_data *data);
+extern int  i2c_bus_transfer(struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+extern int  i2c_bus_probe   (struct i2c_bus *bus, int device_addr);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_BUS_H__
+//------------------------------------------------------------------------------
@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_cache.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Write-through register cache for I2C devices (regmap style).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+// 8bit register address (0x00 ~ 0xFF) 의 값과 valid/volatile/precious bitmap.
+// val_bits 8 : register 당 1 byte, word 는 reg(LSB), reg + 1(MSB) 두 register.
+// val_bits 16 : register 당 word 1개 (value[reg * 2], LSB 먼저). byte 단위 access 는
+//               cache 하지 않고 해당 register 를 invalidate 함.
+//------------------------------------------------------------------------------
+#define I2C_CACHE_REG_MAX   256
+
+#define MAP_TEST(map, reg)  ((map)[(reg) >> 3] &  (1u << ((reg) & 7)))
+#define MAP_SET(map, reg)   ((map)[(reg) >> 3] |= (1u << ((reg) & 7)))
+#define MAP_CLR(map, reg)   ((map)[(reg) >> 3] &= ~(1u << ((reg) & 7)))
+
+struct i2c_cache {
+    int         val_bits;
+    uint8_t     value       [I2C_CACHE_REG_MAX * 2];
+    uint8_t     valid       [I2C_CACHE_MAP_SIZE];
+    /* cache 하지 않는 register */
+    uint8_t     volatile_map[I2C_CACHE_MAP_SIZE];
+    /* read 에 side effect 가 있는 register (cache 하지 않고 sync 에서도 제외) */
+    uint8_t     precious_map[I2C_CACHE_MAP_SIZE];
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static struct i2c_cache *cache_get  (struct i2c_bus *bus, int addr);
+static int      cache_reg_ok        (struct i2c_cache *cache, int reg);
+
+//------------------------------------------------------------------------------
+int  i2c_cache_get      (struct i2c_bus *bus, int reg, uint8_t *val, int len);
+void i2c_cache_put      (struct i2c_bus *bus, int reg, const uint8_t *val, int len);
+int  i2c_cache_get_word (struct i2c_bus *bus, int reg, uint8_t *val);
+void i2c_cache_put_word (struct i2c_bus *bus, int reg, const uint8_t *val);
+void i2c_cache_drop     (struct i2c_bus *bus, int reg, int len);
+void i2c_cache_free     (struct i2c_bus *bus);
+
+int  i2c_cache_attach   (int fd, int device_addr, int val_bits,
+                         const uint8_t *volatile_map, const uint8_t *precious_map);
+int  i2c_cache_detach   (int fd, int device_addr);
+int  i2c_cache_invalidate (int fd, int device_addr);
+int  i2c_cache_sync     (int fd, int device_addr);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static struct i2c_cache *cache_get (struct i2c_bus *bus, int addr)
+{
+    if ((bus == NULL) || (addr < 0) || (addr >= I2C_BUS_ADDR_MAX))
+        return NULL;
+
+    return bus->cache[addr];
+}
+
+//------------------------------------------------------------------------------
+static int cache_reg_ok (struct i2c_cache *cache, int reg)
+{
+    if ((reg < 0) || (reg >= I2C_CACHE_REG_MAX))
+        return 0;
+
+    return !MAP_TEST(cache->volatile_map, reg) && !MAP_TEST(cache->precious_map, reg);
+}
+
+//------------------------------------------------------------------------------
+// 8bit register 의 reg ~ reg + len - 1 이 모두 valid 일 때만 hit. (16bit 는 항상 miss)
+//------------------------------------------------------------------------------
+int i2c_cache_get (struct i2c_bus *bus, int reg, uint8_t *val, int len)
+{
+    struct i2c_cache *cache = cache_get (bus, bus ? bus->addr : -1);
+    int i;
+
+    if ((cache == NULL) || (cache->val_bits == 16))
+        return 0;
+
+    for (i = 0; i < len; i++) {
+        if (!cache_reg_ok (cache, reg + i) || !MAP_TEST(cache->valid, reg + i))
+            return 0;
+    }
+    memcpy (val, &cache->value[reg], len);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 16bit register 에 byte 를 쓴 경우는 word 값을 알 수 없으므로 invalidate.
+//------------------------------------------------------------------------------
+void i2c_cache_put (struct i2c_bus *bus, int reg, const uint8_t *val, int len)
+{
+    struct i2c_cache *cache = cache_get (bus, bus ? bus->addr : -1);
+    int i;
+
+    if (cache == NULL)
+        return;
+
+    if (cache->val_bits == 16) {
+        i2c_cache_drop (bus, reg, len);
+        return;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (!cache_reg_ok (cache, reg + i))
+            continue;
+        cache->value[reg + i] = val[i];
+        MAP_SET(cache->valid, reg + i);
+    }
+}
+
+//------------------------------------------------------------------------------
+// word (val[0] = LSB) 읽기. 8bit 는 reg, reg + 1 register 에 아직 쓰지 않은 write combining
+// byte 를 덮어씀. 16bit 는 register 에 쓰기 대기중인 byte 가 있으면 miss (device read 전 flush).
+//------------------------------------------------------------------------------
+int i2c_cache_get_word (struct i2c_bus *bus, int reg, uint8_t *val)
+{
+    struct i2c_cache *cache = cache_get (bus, bus ? bus->addr : -1);
+    uint8_t pending;
+
+    if (cache == NULL)
+        return 0;
+
+    if (cache->val_bits != 16) {
+        if (!i2c_cache_get (bus, reg, val, 2))
+            return 0;
+        i2c_wc_get (bus, reg,     &val[0]);
+        i2c_wc_get (bus, reg + 1, &val[1]);
+        return 1;
+    }
+    if (!cache_reg_ok (cache, reg) || !MAP_TEST(cache->valid, reg) ||
+        i2c_wc_get (bus, reg, &pending))
+        return 0;
+
+    memcpy (val, &cache->value[reg * 2], 2);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void i2c_cache_put_word (struct i2c_bus *bus, int reg, const uint8_t *val)
+{
+    struct i2c_cache *cache = cache_get (bus, bus ? bus->addr : -1);
+
+    if (cache == NULL)
+        return;
+
+    if (cache->val_bits != 16) {
+        i2c_cache_put (bus, reg, val, 2);
+        return;
+    }
+    if (!cache_reg_ok (cache, reg))
+        return;
+
+    memcpy (&cache->value[reg * 2], val, 2);
+    MAP_SET(cache->valid, reg);
+}
+
+//------------------------------------------------------------------------------
+void i2c_cache_drop (struct i2c_bus *bus, int reg, int len)
+{
+    struct i2c_cache *cache = cache_get (bus, bus ? bus->addr : -1);
+    int i;
+
+    if (cache == NULL)
+        return;
+
+    for (i = 0; i < len; i++) {
+        if ((reg + i >= 0) && (reg + i < I2C_CACHE_REG_MAX))
+            MAP_CLR(cache->valid, reg + i);
+    }
+}
+
+//------------------------------------------------------------------------------
+void i2c_cache_free (struct i2c_bus *bus)
+{
+    int i;
+
+    for (i = 0; i < I2C_BUS_ADDR_MAX; i++) {
+        free (bus->cache[i]);
+        bus->cache[i] = NULL;
+    }
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// device_addr 에 register cache 를 붙임. val_bits 는 register 값의 크기 (8 또는 16,
+// 0 이면 8). map 은 I2C_CACHE_MAP_SIZE byte bitmap (bit = register), NULL 이면 해당
+// register 없음. 이미 있으면 설정만 갱신하고 invalidate. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_cache_attach (int fd, int device_addr, int val_bits,
+                      const uint8_t *volatile_map, const uint8_t *precious_map)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_cache *cache;
+
+    if ((bus == NULL) || (device_addr < 0) || (device_addr >= I2C_BUS_ADDR_MAX))
+        return -1;
+
+    if (!val_bits)
+        val_bits = 8;
+    if ((val_bits != 8) && (val_bits != 16))
+        return -1;
+
+    if ((cache = bus->cache[device_addr]) == NULL) {
+        if ((cache = calloc (1, sizeof(struct i2c_cache))) == NULL)
+            return -1;
+        bus->cache[device_addr] = cache;
+    }
+    memset (cache->valid, 0, I2C_CACHE_MAP_SIZE);
+    cache->val_bits = val_bits;
+
+    if (volatile_map)   memcpy (cache->volatile_map, volatile_map, I2C_CACHE_MAP_SIZE);
+    else                memset (cache->volatile_map, 0, I2C_CACHE_MAP_SIZE);
+    if (precious_map)   memcpy (cache->precious_map, precious_map, I2C_CACHE_MAP_SIZE);
+    else                memset (cache->precious_map, 0, I2C_CACHE_MAP_SIZE);
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_cache_detach (int fd, int device_addr)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if (cache_get (bus, device_addr) == NULL)
+        return -1;
+
+    free (bus->cache[device_addr]);
+    bus->cache[device_addr] = NULL;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 모든 cache 값을 버림. 다음 read 는 device 에서 다시 읽음. (device reset 후 등)
+//------------------------------------------------------------------------------
+int i2c_cache_invalidate (int fd, int device_addr)
+{
+    struct i2c_cache *cache = cache_get (i2c_bus_get (fd), device_addr);
+
+    if (cache == NULL)
+        return -1;
+
+    memset (cache->valid, 0, I2C_CACHE_MAP_SIZE);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// cache 에 있는 값을 모두 device 에 다시 씀. (device 전원/reset 후 설정 복구)
+// bus 의 slave address 는 호출 전 값으로 복구됨. 모두 성공하면 0, 실패가 있으면 -1.
+//------------------------------------------------------------------------------
+int i2c_cache_sync (int fd, int device_addr)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_cache *cache = cache_get (bus, device_addr);
+    union i2c_smbus_data data;
+    int reg, size, prev_addr, ret = 0;
+
+    if (cache == NULL)
+        return -1;
+
+    prev_addr = bus->addr;
+    if (bus->ops->set_addr (bus, device_addr))
+        return -1;
+
+    for (reg = 0; reg < I2C_CACHE_REG_MAX; reg++) {
+        if (!cache_reg_ok (cache, reg) || !MAP_TEST(cache->valid, reg))
+            continue;
+
+        if (cache->val_bits == 16) {
+            data.word = cache->value[reg * 2] | (cache->value[reg * 2 + 1] << 8);
+            size = I2C_SMBUS_WORD_DATA;
+        } else {
+            data.byte = cache->value[reg];
+            size = I2C_SMBUS_BYTE_DATA;
+        }
+        if (i2c_bus_smbus (bus, I2C_SMBUS_WRITE, reg, size, &data)) {
+            MAP_CLR(cache->valid, reg);
+            ret = -1;
+        }
+    }
+    if (prev_addr && (prev_addr != device_addr))
+        bus->ops->set_addr (bus, prev_addr);
+
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
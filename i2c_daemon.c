@@ -0,0 +1,915 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_daemon.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Bus ownership daemon (shared-memory request ring, Unix socket doorbell).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+#include "i2c_daemon.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+// shared memory ring (client 마다 1개, memfd). client 가 slot 을 채우고 head 를 올린 후
+// doorbell (1 byte) 을 보내면 daemon 이 tail 부터 head 까지 실행하고 tail 을 올린 후
+// doorbell 로 응답함. client 는 한번에 1 batch 만 보내므로 ring 이 넘치지 않음.
+//------------------------------------------------------------------------------
+enum {
+    eDAEMON_NOP = 0,
+    eDAEMON_SMBUS,
+    eDAEMON_TRANSFER,
+    eDAEMON_PROBE,
+    eDAEMON_CLOCK,
+    eDAEMON_RECOVER,
+};
+
+struct daemon_msg {
+    uint16_t    addr;
+    uint16_t    flags;
+    uint16_t    len;
+    /* slot buf 안의 위치 */
+    uint16_t    off;
+};
+
+struct daemon_slot {
+    int32_t     type;
+    int32_t     addr;
+    /* SMBus 인자. eDAEMON_CLOCK 은 size 가 clock_hz */
+    int32_t     rw;
+    int32_t     command;
+    int32_t     size;
+    int32_t     nmsgs;
+    /* 결과와 실패시 errno */
+    int32_t     ret;
+    int32_t     err;
+    union i2c_smbus_data    data;
+    struct daemon_msg       msg[I2C_DAEMON_MSG_MAX];
+    uint8_t     buf[I2C_DAEMON_BUF_MAX];
+};
+
+struct daemon_ring {
+    /* client 가 채운 slot 수, daemon 이 실행한 slot 수 */
+    atomic_uint         head;
+    atomic_uint         tail;
+    struct daemon_slot  slot[I2C_DAEMON_RING_MAX];
+};
+
+/* 연결 직후 device_info 에 대한 응답 (memfd 는 SCM_RIGHTS 로 같이 전달) */
+struct daemon_reply {
+    int32_t     status;
+    int32_t     err;
+    uint64_t    funcs;
+};
+
+//------------------------------------------------------------------------------
+// client context (i2c_open 이 돌려준 bus 의 priv). lock 은 같은 bus 를 사용하는
+// thread (async worker 등) 사이의 ring 사용 순서를 지킴.
+//------------------------------------------------------------------------------
+struct i2c_daemon {
+    int                 sock;
+    struct daemon_ring  *ring;
+    pthread_mutex_t     lock;
+};
+
+//------------------------------------------------------------------------------
+// daemon. 1개의 thread 가 poll 로 모든 client 를 처리하므로 bus 사용은 항상 직렬화 됨.
+//------------------------------------------------------------------------------
+struct daemon_bus {
+    char                device[256];
+    int                 fd;
+    int                 ref;
+};
+
+/* ring 이 NULL 이면 device_info 를 기다리는 중 (deadline 까지) */
+struct daemon_conn {
+    int                 sock;
+    struct daemon_bus   *bus;
+    struct daemon_ring  *ring;
+    uint64_t            deadline;
+};
+
+static struct {
+    volatile sig_atomic_t   stop;
+    /* daemon process 안에서는 i2c_open 이 daemon 을 거치지 않음 */
+    int                     server;
+    struct daemon_bus       bus [I2C_DAEMON_BUS_MAX];
+    struct daemon_conn      conn[I2C_DAEMON_CLIENT_MAX];
+} Daemon;
+
+/* socket 권한 : daemon 과 같은 user/group 만 연결 가능 */
+#define DAEMON_SOCK_MODE    0660
+/* 연결 후 device_info 를 보내야 하는 시간 (넘으면 연결 해제) */
+#define DAEMON_HELLO_MS     1000
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static struct daemon_slot *daemon_slot (struct i2c_daemon *d, int idx);
+static int      daemon_call         (struct i2c_daemon *d, int cnt);
+static int      slot_pack           (struct daemon_slot *s, const struct i2c_async_req *req);
+static int      slot_pack_transfer  (struct daemon_slot *s, const struct i2c_msg *msgs, int nmsgs);
+static void     slot_unpack_transfer(const struct daemon_slot *s, struct i2c_msg *msgs, int nmsgs);
+static int      slot_result         (const struct daemon_slot *s);
+static void     batch_local         (int fd, struct i2c_async_req *req);
+
+static struct daemon_bus *daemon_bus_get (const char *device);
+static void     daemon_bus_put      (struct daemon_bus *b);
+static int      daemon_device_check (const char *device, uid_t uid);
+static int      daemon_reply        (int sock, const struct daemon_reply *reply, int memfd);
+static void     daemon_accept       (int lsock);
+static void     daemon_hello        (struct daemon_conn *c);
+static void     daemon_drop         (struct daemon_conn *c);
+static int      daemon_exec_transfer(int fd, struct daemon_slot *s);
+static int      daemon_exec_smbus   (int fd, struct daemon_slot *s);
+static void     daemon_exec         (int fd, struct daemon_slot *s);
+static void     daemon_serve        (struct daemon_conn *c);
+
+//------------------------------------------------------------------------------
+int  i2c_daemon_run     (const char *path);
+void i2c_daemon_stop    (void);
+int  i2c_daemon_batch   (int fd, struct i2c_async_req *req, int cnt);
+
+const char *i2c_daemon_path (void);
+struct i2c_daemon *i2c_daemon_connect (const char *path, const char *device_info,
+                                       int *fd, unsigned long *funcs);
+void i2c_daemon_close       (struct i2c_daemon *d);
+int  i2c_daemon_smbus       (struct i2c_daemon *d, int addr, char rw, uint8_t command,
+                             int size, union i2c_smbus_data *data);
+int  i2c_daemon_transfer    (struct i2c_daemon *d, struct i2c_msg *msgs, int nmsgs);
+int  i2c_daemon_probe       (struct i2c_daemon *d, int addr);
+int  i2c_daemon_set_clock   (struct i2c_daemon *d, int clock_hz);
+int  i2c_daemon_recover     (struct i2c_daemon *d);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 다음 batch 의 idx 번째 slot (d->lock 을 잡고 사용).
+//------------------------------------------------------------------------------
+static struct daemon_slot *daemon_slot (struct i2c_daemon *d, int idx)
+{
+    unsigned int head = atomic_load_explicit (&d->ring->head, memory_order_relaxed);
+
+    return &d->ring->slot[(head + idx) % I2C_DAEMON_RING_MAX];
+}
+
+//------------------------------------------------------------------------------
+// 채운 cnt 개의 slot 을 보내고 daemon 이 모두 실행할 때까지 대기. 연결이 끊기면 -1 (ECONNRESET).
+//------------------------------------------------------------------------------
+static int daemon_call (struct i2c_daemon *d, int cnt)
+{
+    struct daemon_ring *r = d->ring;
+    unsigned int head = atomic_load_explicit (&r->head, memory_order_relaxed) + cnt;
+    ssize_t n;
+    char bell = 0;
+
+    atomic_store_explicit (&r->head, head, memory_order_release);
+    while ((n = send (d->sock, &bell, 1, MSG_NOSIGNAL)) < 0)
+        if (errno != EINTR)
+            goto lost;
+
+    /* 이전 batch 의 늦은 doorbell 이 남아 있을 수 있으므로 tail 로 완료 확인 */
+    while (atomic_load_explicit (&r->tail, memory_order_acquire) != head) {
+        if ((n = recv (d->sock, &bell, 1, 0)) > 0)
+            continue;
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        goto lost;
+    }
+    return 0;
+lost:
+    errno = ECONNRESET;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+static int slot_pack (struct daemon_slot *s, const struct i2c_async_req *req)
+{
+    s->type = eDAEMON_NOP;
+
+    switch (req->type) {
+        case eI2C_ASYNC_SMBUS:
+            s->type    = eDAEMON_SMBUS;
+            s->addr    = req->addr;
+            s->rw      = req->rw;
+            s->command = req->command;
+            s->size    = req->size;
+            s->data    = req->data;
+            return 0;
+        case eI2C_ASYNC_TRANSFER:
+            return slot_pack_transfer (s, req->msgs, req->nmsgs);
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// message 를 slot buf 에 배치. read message 는 len 만큼, I2C_M_RECV_LEN 은 count 만큼
+// 늘어날 수 있으므로 I2C_SMBUS_BLOCK_MAX 를 더 확보함. buf 가 부족하면 -1 (EMSGSIZE).
+//------------------------------------------------------------------------------
+static int slot_pack_transfer (struct daemon_slot *s, const struct i2c_msg *msgs, int nmsgs)
+{
+    int i, off, room;
+
+    if ((msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_DAEMON_MSG_MAX)) {
+        errno = (nmsgs > I2C_DAEMON_MSG_MAX) ? EMSGSIZE : EINVAL;
+        return -1;
+    }
+    for (i = 0, off = 0; i < nmsgs; i++, off += room) {
+        room = msgs[i].len + ((msgs[i].flags & I2C_M_RECV_LEN) ? I2C_SMBUS_BLOCK_MAX : 0);
+        if (off + room > I2C_DAEMON_BUF_MAX) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        s->msg[i].addr  = msgs[i].addr;
+        s->msg[i].flags = msgs[i].flags;
+        s->msg[i].len   = msgs[i].len;
+        s->msg[i].off   = off;
+        if (!(msgs[i].flags & I2C_M_RD))
+            memcpy (&s->buf[off], msgs[i].buf, msgs[i].len);
+    }
+    s->type  = eDAEMON_TRANSFER;
+    s->addr  = msgs[0].addr;
+    s->nmsgs = nmsgs;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void slot_unpack_transfer (const struct daemon_slot *s, struct i2c_msg *msgs, int nmsgs)
+{
+    int i;
+
+    for (i = 0; i < nmsgs; i++) {
+        if (!(msgs[i].flags & I2C_M_RD))
+            continue;
+        msgs[i].len = s->msg[i].len;
+        memcpy (msgs[i].buf, &s->buf[s->msg[i].off], msgs[i].len);
+    }
+}
+
+//------------------------------------------------------------------------------
+static int slot_result (const struct daemon_slot *s)
+{
+    if (s->ret < 0)
+        errno = s->err;
+    return s->ret;
+}
+
+//------------------------------------------------------------------------------
+static void batch_local (int fd, struct i2c_async_req *req)
+{
+    switch (req->type) {
+        case eI2C_ASYNC_SMBUS:
+            if ((req->ret = i2c_set_addr (fd, req->addr)) == 0)
+                req->ret = i2c_smbus_access (fd, req->rw, req->command, req->size, &req->data);
+            break;
+        case eI2C_ASYNC_TRANSFER:
+            req->ret = i2c_transfer (fd, req->msgs, req->nmsgs);
+            break;
+        default:
+            errno    = EINVAL;
+            req->ret = -1;
+            break;
+    }
+    req->err = (req->ret < 0) ? errno : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// device 의 bus 를 찾아 참조 (없으면 i2c_open). 실패시 NULL (errno).
+//------------------------------------------------------------------------------
+static struct daemon_bus *daemon_bus_get (const char *device)
+{
+    struct daemon_bus *b, *empty = NULL;
+    int i;
+
+    for (i = 0; i < I2C_DAEMON_BUS_MAX; i++) {
+        b = &Daemon.bus[i];
+        if (b->ref && !strcmp (b->device, device)) {
+            b->ref++;
+            return b;
+        }
+        if (!b->ref && (empty == NULL))
+            empty = b;
+    }
+    if (empty == NULL) {
+        errno = EMFILE;
+        return NULL;
+    }
+    errno = 0;
+    if ((empty->fd = i2c_open (device)) < 0) {
+        if (!errno)
+            errno = ENODEV;
+        return NULL;
+    }
+    strncpy (empty->device, device, sizeof(empty->device) -1);
+    empty->ref = 1;
+    return empty;
+}
+
+//------------------------------------------------------------------------------
+static void daemon_bus_put (struct daemon_bus *b)
+{
+    if (--b->ref)
+        return;
+
+    i2c_close (b->fd);
+    memset (b, 0, sizeof(struct daemon_bus));
+}
+
+//------------------------------------------------------------------------------
+// daemon 과 다른 user (daemon 은 보통 root) 의 client 는 daemon 권한으로 임의의 file 을
+// 열 수 있는 device_info 를 사용할 수 없음 : GPIOMEM 의 PATH, /dev/i2c-N 이 아닌 node,
+// /dev/gpiochipN 이 아닌 chip node. 허용하면 0, 아니면 -1 (errno = EPERM).
+//------------------------------------------------------------------------------
+static int daemon_device_check (const char *device, uid_t uid)
+{
+    char info[256], *p, *save;
+
+    if ((uid == 0) || (uid == geteuid ()))
+        return 0;
+
+    memset (info, 0, sizeof(info));
+    strncpy (info, device, sizeof(info) -1);
+    if ((strstr (info, "..") != NULL) || ((p = strtok_r (info, ",", &save)) == NULL))
+        goto err_out;
+
+    if (p[0] == '/') {
+        if (strncmp (p, "/dev/i2c-", strlen ("/dev/i2c-")))
+            goto err_out;
+        return 0;
+    }
+    if (!strcasecmp (p, "GPIOCHIP")) {
+        if ((p = strtok_r (NULL, ",", &save)) == NULL)
+            goto err_out;
+        if ((p[0] == '/') && strncmp (p, "/dev/gpiochip", strlen ("/dev/gpiochip")))
+            goto err_out;
+    }
+    while ((p = strtok_r (NULL, ",", &save)) != NULL)
+        if (!strcasecmp (p, "PATH"))
+            goto err_out;
+    return 0;
+
+err_out:
+    errno = EPERM;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+static int daemon_reply (int sock, const struct daemon_reply *reply, int memfd)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { .iov_base = (void *)reply, .iov_len = sizeof(struct daemon_reply) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    struct cmsghdr *cmsg;
+
+    if (memfd >= 0) {
+        memset (cbuf, 0, sizeof(cbuf));
+        msg.msg_control    = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+        cmsg = CMSG_FIRSTHDR (&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN (sizeof(int));
+        memcpy (CMSG_DATA (cmsg), &memfd, sizeof(int));
+    }
+    return (sendmsg (sock, &msg, MSG_NOSIGNAL) == sizeof(struct daemon_reply)) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+// 새 client : 빈 연결 slot 에 등록만 함. device_info 는 poll 에서 수신 가능할 때 읽으므로
+// (daemon_hello) 보내지 않는 client 가 다른 client 의 요청 처리를 멈추지 않음.
+//------------------------------------------------------------------------------
+static void daemon_accept (int lsock)
+{
+    struct daemon_reply reply = { .status = -1, .err = EMFILE };
+    int i, sock;
+
+    if ((sock = accept4 (lsock, NULL, NULL, SOCK_CLOEXEC)) < 0)
+        return;
+
+    for (i = 0; i < I2C_DAEMON_CLIENT_MAX; i++)
+        if (Daemon.conn[i].sock < 0) {
+            Daemon.conn[i].sock     = sock;
+            Daemon.conn[i].deadline = gpio_delay_now () + (uint64_t)DAEMON_HELLO_MS * 1000000;
+            return;
+        }
+    daemon_reply (sock, &reply, -1);
+    close (sock);
+}
+
+//------------------------------------------------------------------------------
+// 연결 후 첫 message : device_info 를 받아 bus 를 열고 ring (memfd) 을 전달.
+// 실패하면 응답 후 연결 해제.
+//------------------------------------------------------------------------------
+static void daemon_hello (struct daemon_conn *c)
+{
+    struct daemon_reply reply = { .status = -1 };
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+    char device[256];
+    ssize_t len;
+    int memfd = -1;
+
+    if ((len = recv (c->sock, device, sizeof(device) -1, MSG_DONTWAIT)) < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+            return;
+    }
+    if (len <= 0) {
+        reply.err = EPROTO;
+        goto out;
+    }
+    device[len] = 0;
+
+    if (getsockopt (c->sock, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) ||
+        daemon_device_check (device, cred.uid)) {
+        reply.err = EPERM;
+        fprintf (stderr, "%s : %s : permission denied\n", __func__, device);
+        goto out;
+    }
+    if ((c->bus = daemon_bus_get (device)) == NULL) {
+        reply.err = errno;
+        fprintf (stderr, "%s : %s : %s\n", __func__, device, strerror (errno));
+        goto out;
+    }
+    if (((memfd = memfd_create ("i2c_daemon", MFD_CLOEXEC)) < 0) ||
+        ftruncate (memfd, sizeof(struct daemon_ring)) ||
+        ((c->ring = mmap (NULL, sizeof(struct daemon_ring), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, memfd, 0)) == MAP_FAILED)) {
+        reply.err = errno;
+        c->ring   = NULL;
+        goto out;
+    }
+    reply.status = 0;
+    reply.funcs  = i2c_bus_get (c->bus->fd)->funcs;
+out:
+    if (daemon_reply (c->sock, &reply, reply.status ? -1 : memfd) || reply.status)
+        daemon_drop (c);
+
+    if (memfd >= 0)
+        close (memfd);
+}
+
+//------------------------------------------------------------------------------
+static void daemon_drop (struct daemon_conn *c)
+{
+    close (c->sock);
+    if (c->ring != NULL)
+        munmap (c->ring, sizeof(struct daemon_ring));
+    if (c->bus != NULL)
+        daemon_bus_put (c->bus);
+
+    c->sock = -1;
+    c->ring = NULL;
+    c->bus  = NULL;
+}
+
+//------------------------------------------------------------------------------
+// client 가 바꿀 수 있는 slot 의 message 정보와 data 는 복사 후 검사하여 사용.
+// (backend 가 검사한 길이를 다시 읽는 사이에 client 가 바꿀 수 있음)
+//------------------------------------------------------------------------------
+static int daemon_exec_transfer (int fd, struct daemon_slot *s)
+{
+    struct i2c_msg msgs[I2C_DAEMON_MSG_MAX];
+    uint8_t buf[I2C_DAEMON_BUF_MAX];
+    struct daemon_msg m;
+    int i, nmsgs = s->nmsgs, ret;
+
+    if ((nmsgs <= 0) || (nmsgs > I2C_DAEMON_MSG_MAX)) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < nmsgs; i++) {
+        m = s->msg[i];
+        if (m.off + m.len + ((m.flags & I2C_M_RECV_LEN) ? I2C_SMBUS_BLOCK_MAX : 0)
+                > I2C_DAEMON_BUF_MAX) {
+            errno = EINVAL;
+            return -1;
+        }
+        msgs[i].addr  = m.addr;
+        msgs[i].flags = m.flags;
+        msgs[i].len   = m.len;
+        msgs[i].buf   = &buf[m.off];
+    }
+    memcpy (buf, s->buf, sizeof(buf));
+    ret = i2c_transfer (fd, msgs, nmsgs);
+    memcpy (s->buf, buf, sizeof(buf));
+    for (i = 0; i < nmsgs; i++)
+        s->msg[i].len = msgs[i].len;
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// SMBus 인자와 data 도 같은 이유로 복사하여 실행하고 결과만 slot 에 돌려줌.
+//------------------------------------------------------------------------------
+static int daemon_exec_smbus (int fd, struct daemon_slot *s)
+{
+    union i2c_smbus_data data = s->data;
+    int rw = s->rw, command = s->command, size = s->size, ret;
+
+    if ((ret = i2c_set_addr (fd, s->addr)) == 0)
+        ret = i2c_smbus_access (fd, rw, command, size, &data);
+    s->data = data;
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+static void daemon_exec (int fd, struct daemon_slot *s)
+{
+    int ret;
+
+    errno = 0;
+    switch (s->type) {
+        case eDAEMON_SMBUS:     ret = daemon_exec_smbus (fd, s);        break;
+        case eDAEMON_TRANSFER:  ret = daemon_exec_transfer (fd, s);     break;
+        case eDAEMON_PROBE:     ret = i2c_probe     (fd, s->addr);      break;
+        case eDAEMON_CLOCK:     ret = i2c_set_clock (fd, s->size);      break;
+        case eDAEMON_RECOVER:   ret = i2c_recover   (fd);               break;
+        case eDAEMON_NOP:
+        default:                ret = -1;   errno = EINVAL;             break;
+    }
+    s->ret = ret;
+    s->err = (ret < 0) ? (errno ? errno : EIO) : 0;
+}
+
+//------------------------------------------------------------------------------
+// doorbell 수신 : 쌓인 doorbell 을 모두 읽고 ring 의 새 요청을 실행한 후 응답.
+//------------------------------------------------------------------------------
+static void daemon_serve (struct daemon_conn *c)
+{
+    struct daemon_ring *r = c->ring;
+    unsigned int head, tail;
+    char bell[16];
+    ssize_t n;
+
+    while ((n = recv (c->sock, bell, sizeof(bell), MSG_DONTWAIT)) > 0)
+        ;
+    if ((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+        daemon_drop (c);
+        return;
+    }
+
+    head = atomic_load_explicit (&r->head, memory_order_acquire);
+    tail = atomic_load_explicit (&r->tail, memory_order_relaxed);
+    if (head - tail > I2C_DAEMON_RING_MAX) {
+        fprintf (stderr, "%s : ring overrun (head %u, tail %u)\n", __func__, head, tail);
+        daemon_drop (c);
+        return;
+    }
+    if (head == tail)
+        return;
+
+    for (; tail != head; tail++)
+        daemon_exec (c->bus->fd, &r->slot[tail % I2C_DAEMON_RING_MAX]);
+
+    atomic_store_explicit (&r->tail, tail, memory_order_release);
+    send (c->sock, bell, 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// path 에 socket 을 만들고 i2c_daemon_stop 이 호출될 때까지 client 요청을 처리.
+// 종료시 모든 연결과 bus 를 닫고 socket 을 지움. 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_daemon_run (const char *path)
+{
+    struct pollfd pfd[1 + I2C_DAEMON_CLIENT_MAX];
+    struct sockaddr_un sa;
+    struct daemon_conn *c;
+    int i, lsock;
+
+    if ((path == NULL) || (strlen (path) >= sizeof(sa.sun_path))) {
+        fprintf (stderr, "%s : invalid socket path\n", __func__);
+        return -1;
+    }
+    memset (&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy (sa.sun_path, path);
+
+    if ((lsock = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+
+    /* 이전 daemon 이 남긴 socket. umask 와 관계없이 other 는 연결할 수 없도록 설정 */
+    unlink (path);
+    if (bind (lsock, (struct sockaddr *)&sa, sizeof(sa)) || chmod (path, DAEMON_SOCK_MODE) ||
+        listen (lsock, 16)) {
+        fprintf (stderr, "%s : %s : %s\n", __func__, path, strerror (errno));
+        close (lsock);
+        return -1;
+    }
+
+    Daemon.server = 1;
+    for (i = 0; i < I2C_DAEMON_CLIENT_MAX; i++)
+        Daemon.conn[i].sock = -1;
+
+    while (!Daemon.stop) {
+        pfd[0].fd     = lsock;
+        pfd[0].events = POLLIN;
+        for (i = 0; i < I2C_DAEMON_CLIENT_MAX; i++) {
+            c = &Daemon.conn[i];
+            /* 제한 시간 안에 device_info 를 보내지 않은 연결 */
+            if ((c->sock >= 0) && (c->ring == NULL) && (gpio_delay_now () > c->deadline))
+                daemon_drop (c);
+            pfd[1 + i].fd     = c->sock;
+            pfd[1 + i].events = POLLIN;
+        }
+        if (poll (pfd, 1 + I2C_DAEMON_CLIENT_MAX, 500) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (i = 0; i < I2C_DAEMON_CLIENT_MAX; i++) {
+            if ((pfd[1 + i].fd < 0) || !pfd[1 + i].revents)
+                continue;
+            if (Daemon.conn[i].ring == NULL)
+                daemon_hello (&Daemon.conn[i]);
+            else
+                daemon_serve (&Daemon.conn[i]);
+        }
+        if (pfd[0].revents & POLLIN)
+            daemon_accept (lsock);
+    }
+
+    for (i = 0; i < I2C_DAEMON_CLIENT_MAX; i++)
+        if (Daemon.conn[i].sock >= 0)
+            daemon_drop (&Daemon.conn[i]);
+
+    close (lsock);
+    unlink (path);
+    Daemon.server = 0;
+    Daemon.stop   = 0;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void i2c_daemon_stop (void)
+{
+    Daemon.stop = 1;
+}
+
+//------------------------------------------------------------------------------
+int i2c_daemon_batch (int fd, struct i2c_async_req *req, int cnt)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_daemon *d;
+    struct daemon_slot *s;
+    int i, n, done, ret = 0;
+
+    if ((bus == NULL) || (req == NULL) || (cnt < 0))
+        return -1;
+
+    if (bus->mode != eI2C_MODE_DAEMON) {
+        for (i = 0; i < cnt; i++)
+            batch_local (fd, &req[i]);
+    }
+    else {
+        d = bus->priv;
+        i2c_wc_flush_bus (bus);
+
+        pthread_mutex_lock (&d->lock);
+        for (done = 0; done < cnt; done += n) {
+            n = (cnt - done < I2C_DAEMON_RING_MAX) ? cnt - done : I2C_DAEMON_RING_MAX;
+
+            /* 보낼 수 없는 요청은 NOP slot 으로 두고 바로 실패 처리 */
+            for (i = 0; i < n; i++)
+                if (slot_pack (daemon_slot (d, i), &req[done + i])) {
+                    req[done + i].ret = -1;
+                    req[done + i].err = errno;
+                }
+
+            if (daemon_call (d, n)) {
+                for (i = done; i < cnt; i++) {
+                    req[i].ret = -1;
+                    req[i].err = ECONNRESET;
+                }
+                ret = -1;
+                break;
+            }
+            for (i = 0; i < n; i++) {
+                /* daemon_call 후 head 가 올라갔으므로 이번 batch 는 -n 부터 */
+                s = daemon_slot (d, i - n);
+                if (s->type == eDAEMON_NOP)
+                    continue;
+                req[done + i].ret = s->ret;
+                req[done + i].err = s->err;
+                if (s->type == eDAEMON_SMBUS)
+                    req[done + i].data = s->data;
+                else
+                    slot_unpack_transfer (s, req[done + i].msgs, req[done + i].nmsgs);
+            }
+        }
+        pthread_mutex_unlock (&d->lock);
+    }
+
+    for (i = 0; i < cnt; i++)
+        if (req[i].complete)
+            req[i].complete (&req[i]);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// daemon socket 경로 (환경 변수 I2C_DAEMON_ENV). 없거나 daemon process 안이면 NULL.
+//------------------------------------------------------------------------------
+const char *i2c_daemon_path (void)
+{
+    const char *path;
+
+    if (Daemon.server)
+        return NULL;
+
+    path = getenv (I2C_DAEMON_ENV);
+    return (path && *path) ? path : NULL;
+}
+
+//------------------------------------------------------------------------------
+// daemon 에 연결하여 device_info 의 bus 를 요청. fd 는 연결 socket (bus 의 fd 로 사용).
+//------------------------------------------------------------------------------
+struct i2c_daemon *i2c_daemon_connect (const char *path, const char *device_info,
+                                       int *fd, unsigned long *funcs)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct daemon_reply reply;
+    struct iovec iov = { .iov_base = &reply, .iov_len = sizeof(reply) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1,
+                          .msg_control = cbuf, .msg_controllen = sizeof(cbuf) };
+    struct cmsghdr *cmsg;
+    struct sockaddr_un sa;
+    struct i2c_daemon *d;
+    struct daemon_ring *ring;
+    int sock, memfd = -1;
+
+    if ((strlen (path) >= sizeof(sa.sun_path)) || (strlen (device_info) >= 256)) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    memset (&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy (sa.sun_path, path);
+
+    if ((sock = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0)
+        return NULL;
+
+    if (connect (sock, (struct sockaddr *)&sa, sizeof(sa)) ||
+        (send (sock, device_info, strlen (device_info), MSG_NOSIGNAL) < 0) ||
+        (recvmsg (sock, &msg, MSG_CMSG_CLOEXEC) != sizeof(reply))) {
+        fprintf (stderr, "%s : %s : %s\n", __func__, path, strerror (errno));
+        close (sock);
+        return NULL;
+    }
+    if (reply.status) {
+        fprintf (stderr, "%s : %s : %s\n", __func__, device_info, strerror (reply.err));
+        close (sock);
+        errno = reply.err;
+        return NULL;
+    }
+    if (((cmsg = CMSG_FIRSTHDR (&msg)) != NULL) && (cmsg->cmsg_type == SCM_RIGHTS))
+        memcpy (&memfd, CMSG_DATA (cmsg), sizeof(int));
+
+    ring = (memfd < 0) ? MAP_FAILED :
+        mmap (NULL, sizeof(struct daemon_ring), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (memfd >= 0)
+        close (memfd);
+
+    if ((ring == MAP_FAILED) || ((d = calloc (1, sizeof(struct i2c_daemon))) == NULL)) {
+        fprintf (stderr, "%s : ring map error\n", __func__);
+        if (ring != MAP_FAILED)
+            munmap (ring, sizeof(struct daemon_ring));
+        close (sock);
+        return NULL;
+    }
+    d->sock = sock;
+    d->ring = ring;
+    pthread_mutex_init (&d->lock, NULL);
+
+    *fd    = sock;
+    *funcs = reply.funcs;
+    return d;
+}
+
+//------------------------------------------------------------------------------
+void i2c_daemon_close (struct i2c_daemon *d)
+{
+    munmap (d->ring, sizeof(struct daemon_ring));
+    close (d->sock);
+    pthread_mutex_destroy (&d->lock);
+    free (d);
+}
+
+//------------------------------------------------------------------------------
+int i2c_daemon_smbus (struct i2c_daemon *d, int addr, char rw, uint8_t command,
+                      int size, union i2c_smbus_data *data)
+{
+    struct daemon_slot *s;
+    int ret = -1;
+
+    pthread_mutex_lock (&d->lock);
+    s = daemon_slot (d, 0);
+    s->type    = eDAEMON_SMBUS;
+    s->addr    = addr;
+    s->rw      = rw;
+    s->command = command;
+    s->size    = size;
+    if (data)
+        s->data = *data;
+
+    if (!daemon_call (d, 1)) {
+        if (data)
+            *data = s->data;
+        ret = slot_result (s);
+    }
+    pthread_mutex_unlock (&d->lock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int i2c_daemon_transfer (struct i2c_daemon *d, struct i2c_msg *msgs, int nmsgs)
+{
+    struct daemon_slot *s;
+    int ret = -1;
+
+    pthread_mutex_lock (&d->lock);
+    s = daemon_slot (d, 0);
+    if (!slot_pack_transfer (s, msgs, nmsgs) && !daemon_call (d, 1)) {
+        slot_unpack_transfer (s, msgs, nmsgs);
+        ret = slot_result (s);
+    }
+    pthread_mutex_unlock (&d->lock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int i2c_daemon_probe (struct i2c_daemon *d, int addr)
+{
+    struct daemon_slot *s;
+    int ret = -1;
+
+    pthread_mutex_lock (&d->lock);
+    s = daemon_slot (d, 0);
+    s->type = eDAEMON_PROBE;
+    s->addr = addr;
+    if (!daemon_call (d, 1))
+        ret = slot_result (s);
+    pthread_mutex_unlock (&d->lock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// daemon 의 bus clock 을 바꾸므로 같은 bus 를 사용하는 모든 client 에 적용됨.
+//------------------------------------------------------------------------------
+int i2c_daemon_set_clock (struct i2c_daemon *d, int clock_hz)
+{
+    struct daemon_slot *s;
+    int ret = -1;
+
+    pthread_mutex_lock (&d->lock);
+    s = daemon_slot (d, 0);
+    s->type = eDAEMON_CLOCK;
+    s->size = clock_hz;
+    if (!daemon_call (d, 1))
+        ret = slot_result (s);
+    pthread_mutex_unlock (&d->lock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int i2c_daemon_recover (struct i2c_daemon *d)
+{
+    struct daemon_slot *s;
+    int ret = -1;
+
+    pthread_mutex_lock (&d->lock);
+    s = daemon_slot (d, 0);
+    s->type = eDAEMON_RECOVER;
+    if (!daemon_call (d, 1))
+        ret = slot_result (s);
+    pthread_mutex_unlock (&d->lock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_daemon.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Bus ownership daemon (shared-memory request ring, Unix socket doorbell).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_DAEMON_H__
+#define __I2C_DAEMON_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "i2c_async.h"
+
+//------------------------------------------------------------------------------
+// 환경 변수 LIB_I2C_DAEMON 에 daemon socket 경로가 있으면 i2c_open 은 bus 를 직접 열지
+// 않고 daemon 에 연결함 (device_info 는 daemon 이 열고, 같은 device_info 는 process 간에
+// bus 1개를 공유). 요청은 client 별 shared memory ring 에 넣고 socket 으로 doorbell 만 보냄.
+//------------------------------------------------------------------------------
+#define I2C_DAEMON_ENV          "LIB_I2C_DAEMON"
+
+/* 동시 접속 client 수, daemon 이 여는 bus 수 */
+#define I2C_DAEMON_CLIENT_MAX   64
+#define I2C_DAEMON_BUS_MAX      32
+
+/* client ring 의 slot 수 (doorbell 1회에 처리되는 최대 요청 수) */
+#define I2C_DAEMON_RING_MAX     64
+/* slot 1개 (transfer 요청 1개) 의 message 수와 data buffer 크기 */
+#define I2C_DAEMON_MSG_MAX      8
+#define I2C_DAEMON_BUF_MAX      512
+
+//------------------------------------------------------------------------------
+// daemon (lib_main -d). i2c_daemon_stop 은 signal handler 에서 호출 가능.
+//------------------------------------------------------------------------------
+extern int  i2c_daemon_run      (const char *path);
+extern void i2c_daemon_stop     (void);
+
+//------------------------------------------------------------------------------
+// cnt 개의 요청 (struct i2c_async_req 의 type, addr, smbus/transfer 인자) 을 순서대로 실행.
+// daemon bus 는 I2C_DAEMON_RING_MAX 개씩 doorbell 1회로 보내고, 그 외 bus 는 바로 실행.
+// 결과는 req->ret/err 에 저장하고 complete 가 있으면 호출. register cache 는 거치지 않음.
+// 모두 실행하면 0, daemon 연결이 끊기면 -1 (실행하지 못한 요청은 ret -1).
+//------------------------------------------------------------------------------
+extern int  i2c_daemon_batch    (int fd, struct i2c_async_req *req, int cnt);
+
+//------------------------------------------------------------------------------
+// daemon client backend (lib_i2c.c 내부용). path 는 daemon 을 사용하지 않으면 NULL.
+//------------------------------------------------------------------------------
+struct i2c_daemon;
+
+extern const char *i2c_daemon_path  (void);
+extern struct i2c_daemon *i2c_daemon_connect (const char *path, const char *device_info,
+                                              int *fd, unsigned long *funcs);
+extern void i2c_daemon_close        (struct i2c_daemon *d);
+extern int  i2c_daemon_smbus        (struct i2c_daemon *d, int addr, char rw, uint8_t command,
+                                     int size, union i2c_smbus_data *data);
+extern int  i2c_daemon_transfer     (struct i2c_daemon *d, struct i2c_msg *msgs, int nmsgs);
+extern int  i2c_daemon_probe        (struct i2c_daemon *d, int addr);
+extern int  i2c_daemon_set_clock    (struct i2c_daemon *d, int clock_hz);
+extern int  i2c_daemon_recover      (struct i2c_daemon *d);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_DAEMON_H__
+//------------------------------------------------------------------------------
@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_eeprom.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief 24Cxx serial EEPROM page write / ACK polling / block read.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+// 한번에 읽는 크기 (daemon bus 의 transfer buffer 안에 들어가도록) 와 page 최대 크기.
+// ACK polling 간격은 100KHz 에서 address 1회 (약 100us) 정도로 bus 를 계속 점유하지 않게 함.
+//------------------------------------------------------------------------------
+#define EEPROM_READ_MAX     256
+#define EEPROM_PAGE_MAX     256
+#define EEPROM_TWR_DEFAULT  10000
+#define EEPROM_POLL_NS      100000
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      ee_check        (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 const void *buf, uint32_t len);
+static int      ee_addr_bytes   (const struct i2c_eeprom *ee);
+static int      ee_slave        (const struct i2c_eeprom *ee, uint32_t offset);
+static int      ee_page         (const struct i2c_eeprom *ee);
+static int      ee_i2c          (int fd);
+static int      ee_write_page   (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 const uint8_t *buf, int len);
+static int      ee_read_chunk   (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 uint8_t *buf, int len);
+
+//------------------------------------------------------------------------------
+int i2c_eeprom_wait     (int fd, const struct i2c_eeprom *ee);
+int i2c_eeprom_read     (int fd, const struct i2c_eeprom *ee, uint32_t offset, uint8_t *buf, uint32_t len);
+int i2c_eeprom_write    (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len);
+int i2c_eeprom_verify   (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len);
+int i2c_eeprom_program  (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int ee_check (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                     const void *buf, uint32_t len)
+{
+    if ((i2c_bus_get (fd) == NULL) || (ee == NULL) || (buf == NULL) || !ee->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((offset >= ee->size) || (len > ee->size - offset)) {
+        fprintf (stderr, "%s : 0x%x + %u out of range (size %u)\n", __func__, offset, len, ee->size);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// memory address byte 수. 0 이면 256 byte 보다 큰 EEPROM (24C32 이상) 은 2 byte.
+//------------------------------------------------------------------------------
+static int ee_addr_bytes (const struct i2c_eeprom *ee)
+{
+    if (ee->addr_bytes)
+        return ee->addr_bytes;
+
+    return (ee->size > 256) ? 2 : 1;
+}
+
+//------------------------------------------------------------------------------
+// 1 byte address 로 256 byte 보다 큰 EEPROM (24C04/08/16) 은 slave address 의
+// 하위 bit 가 256 byte block 선택.
+//------------------------------------------------------------------------------
+static int ee_slave (const struct i2c_eeprom *ee, uint32_t offset)
+{
+    if (ee_addr_bytes (ee) == 1)
+        return ee->addr | ((offset >> 8) & 0x07);
+
+    return ee->addr;
+}
+
+//------------------------------------------------------------------------------
+static int ee_page (const struct i2c_eeprom *ee)
+{
+    if (ee->page <= 0)
+        return 1;
+
+    return (ee->page > EEPROM_PAGE_MAX) ? EEPROM_PAGE_MAX : ee->page;
+}
+
+//------------------------------------------------------------------------------
+// I2C_RDWR 를 사용할 수 있으면 1. 아니면 SMBus I2C block (32 byte) 로 처리.
+//------------------------------------------------------------------------------
+static int ee_i2c (int fd)
+{
+    return (i2c_bus_get (fd)->funcs & I2C_FUNC_I2C) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// page 안의 len byte 를 write 1회로 씀 (memory address + data).
+// SMBus 만 지원하는 adapter 는 address 의 첫 byte 를 command 로 사용.
+//------------------------------------------------------------------------------
+static int ee_write_page (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                          const uint8_t *buf, int len)
+{
+    uint8_t wbuf[2 + EEPROM_PAGE_MAX];
+    union i2c_smbus_data data;
+    struct i2c_msg msg;
+    int ab = ee_addr_bytes (ee);
+
+    if (ab == 2) {
+        wbuf[0] = (offset >> 8) & 0xFF;
+        wbuf[1] = offset & 0xFF;
+    }
+    else
+        wbuf[0] = offset & 0xFF;
+    memcpy (&wbuf[ab], buf, len);
+
+    if (ee_i2c (fd)) {
+        msg.addr  = ee_slave (ee, offset);
+        msg.flags = 0;
+        msg.len   = ab + len;
+        msg.buf   = wbuf;
+        return (i2c_transfer (fd, &msg, 1) == 1) ? 0 : -1;
+    }
+
+    if (i2c_set_addr (fd, ee_slave (ee, offset)))
+        return -1;
+    data.block[0] = ab - 1 + len;
+    memcpy (&data.block[1], &wbuf[1], data.block[0]);
+    return i2c_smbus_access (fd, I2C_SMBUS_WRITE, wbuf[0], I2C_SMBUS_I2C_BLOCK_DATA, &data);
+}
+
+//------------------------------------------------------------------------------
+// memory address write 후 repeated START 로 len byte read.
+// SMBus 만 지원하면 1 byte address 는 I2C block read (32 byte),
+// 2 byte address 는 address 설정 후 receive byte 로 1 byte 씩 읽음.
+//------------------------------------------------------------------------------
+static int ee_read_chunk (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                          uint8_t *buf, int len)
+{
+    union i2c_smbus_data data;
+    struct i2c_msg msgs[2];
+    uint8_t wbuf[2];
+    int i, ab = ee_addr_bytes (ee), slave = ee_slave (ee, offset);
+
+    if (ee_i2c (fd)) {
+        if (ab == 2) {
+            wbuf[0] = (offset >> 8) & 0xFF;
+            wbuf[1] = offset & 0xFF;
+        }
+        else
+            wbuf[0] = offset & 0xFF;
+
+        msgs[0].addr  = slave;  msgs[0].flags = 0;          msgs[0].len = ab;   msgs[0].buf = wbuf;
+        msgs[1].addr  = slave;  msgs[1].flags = I2C_M_RD;   msgs[1].len = len;  msgs[1].buf = buf;
+        return (i2c_transfer (fd, msgs, 2) == 2) ? 0 : -1;
+    }
+
+    if (i2c_set_addr (fd, slave))
+        return -1;
+
+    if (ab == 1) {
+        for (i = 0; i < len; i += data.block[0]) {
+            data.block[0] = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+            if (i2c_smbus_access (fd, I2C_SMBUS_READ, (offset + i) & 0xFF,
+                                  I2C_SMBUS_I2C_BLOCK_DATA, &data))
+                return -1;
+            memcpy (&buf[i], &data.block[1], data.block[0]);
+        }
+        return 0;
+    }
+
+    data.byte = offset & 0xFF;
+    if (i2c_smbus_access (fd, I2C_SMBUS_WRITE, (offset >> 8) & 0xFF, I2C_SMBUS_BYTE_DATA, &data))
+        return -1;
+    for (i = 0; i < len; i++) {
+        if (i2c_smbus_access (fd, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data))
+            return -1;
+        buf[i] = data.byte;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// write cycle 종료 대기 (ACK polling). EEPROM 은 write cycle 동안 address 에 NACK 하므로
+// 응답할 때까지 probe 를 반복. twr_us 안에 응답하지 않으면 -1 (ETIMEDOUT).
+//------------------------------------------------------------------------------
+int i2c_eeprom_wait (int fd, const struct i2c_eeprom *ee)
+{
+    uint64_t timeout, start = gpio_delay_now ();
+
+    if ((ee == NULL) || (i2c_bus_get (fd) == NULL))
+        return -1;
+
+    timeout = (uint64_t)((ee->twr_us > 0) ? ee->twr_us : EEPROM_TWR_DEFAULT) * 1000;
+    while (i2c_probe (fd, ee->addr)) {
+        if ((gpio_delay_now () - start) > timeout) {
+            fprintf (stderr, "%s : 0x%02x no ACK after %u us\n", __func__, ee->addr,
+                (unsigned)(timeout / 1000));
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        gpio_delay_ns (EEPROM_POLL_NS);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// offset 부터 len byte 를 block read. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_eeprom_read (int fd, const struct i2c_eeprom *ee, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    uint32_t pos, size;
+
+    if (ee_check (fd, ee, offset, buf, len))
+        return -1;
+
+    for (pos = 0; pos < len; pos += size) {
+        size = ((len - pos) > EEPROM_READ_MAX) ? EEPROM_READ_MAX : (len - pos);
+        /* 24C04/08/16 은 256 byte block 을 넘지 않도록 */
+        if ((ee_addr_bytes (ee) == 1) && (((offset + pos) & 0xFF) + size > 256))
+            size = 256 - ((offset + pos) & 0xFF);
+        if (ee_read_chunk (fd, ee, offset + pos, &buf[pos], size))
+            return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// offset 부터 len byte 를 page 경계에 맞춘 page write 로 씀. page 마다 write cycle 종료를
+// ACK polling 으로 확인하므로 함수가 끝나면 바로 read 할 수 있음. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_eeprom_write (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len)
+{
+    uint32_t pos, size, page, max;
+
+    if (ee_check (fd, ee, offset, buf, len))
+        return -1;
+
+    /* SMBus I2C block write 는 address 를 포함하여 33 byte 까지 (page 안에서 나누어 씀) */
+    page = ee_page (ee);
+    max  = ee_i2c (fd) ? page : (uint32_t)(I2C_SMBUS_BLOCK_MAX + 1 - ee_addr_bytes (ee));
+
+    for (pos = 0; pos < len; pos += size) {
+        size = page - ((offset + pos) % page);
+        if (size > max)
+            size = max;
+        if (size > len - pos)
+            size = len - pos;
+
+        if (ee_write_page (fd, ee, offset + pos, &buf[pos], size)) {
+            fprintf (stderr, "%s : page write error at 0x%x\n", __func__, offset + pos);
+            return -1;
+        }
+        if (i2c_eeprom_wait (fd, ee))
+            return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// offset 부터 len byte 를 읽어 buf 와 비교. 같으면 0, 다르면 -1 (EIO).
+//------------------------------------------------------------------------------
+int i2c_eeprom_verify (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len)
+{
+    uint8_t rbuf[EEPROM_READ_MAX];
+    uint32_t pos, size, i;
+
+    if (ee_check (fd, ee, offset, buf, len))
+        return -1;
+
+    for (pos = 0; pos < len; pos += size) {
+        size = ((len - pos) > EEPROM_READ_MAX) ? EEPROM_READ_MAX : (len - pos);
+        if (i2c_eeprom_read (fd, ee, offset + pos, rbuf, size))
+            return -1;
+        for (i = 0; i < size; i++) {
+            if (rbuf[i] != buf[pos + i]) {
+                fprintf (stderr, "%s : 0x%x read 0x%02x, expected 0x%02x\n", __func__,
+                    offset + pos + i, rbuf[i], buf[pos + i]);
+                errno = EIO;
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_eeprom_program (int fd, const struct i2c_eeprom *ee, uint32_t offset, const uint8_t *buf, uint32_t len)
+{
+    if (i2c_eeprom_write (fd, ee, offset, buf, len))
+        return -1;
+
+    return i2c_eeprom_verify (fd, ee, offset, buf, len);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
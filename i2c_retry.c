@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_retry.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Per bus / per device transaction retry policy with backoff.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+// bus 기본 policy 와 slave address 별 policy. retries 가 0 인 policy 는 사용하지 않음.
+//------------------------------------------------------------------------------
+struct i2c_retry {
+    struct i2c_retry_policy bus;
+    struct i2c_retry_policy dev[I2C_BUS_ADDR_MAX];
+};
+
+/* errnos 가 비어있는 policy 의 retry 대상 (NACK, 중재/timeout, 일시적인 I/O error) */
+static const int RetryErrnoDefault[] = {
+    ENXIO, EREMOTEIO, EAGAIN, EBUSY, ETIMEDOUT, EIO, 0,
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      retry_errno_match   (const struct i2c_retry_policy *policy, int err);
+static void     retry_backoff       (const struct i2c_retry_policy *policy, int attempt);
+
+//------------------------------------------------------------------------------
+const struct i2c_retry_policy *i2c_retry_policy (struct i2c_bus *bus, int addr);
+int  i2c_retry_next     (struct i2c_bus *bus, const struct i2c_retry_policy *policy,
+                         int addr, int attempt);
+void i2c_retry_free     (struct i2c_bus *bus);
+
+int  i2c_retry_set      (int fd, int device_addr, const struct i2c_retry_policy *policy);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int retry_errno_match (const struct i2c_retry_policy *policy, int err)
+{
+    const int *list = policy->errnos[0] ? policy->errnos : RetryErrnoDefault;
+    int i;
+
+    for (i = 0; (i < I2C_RETRY_ERRNO_MAX) && list[i]; i++)
+        if (list[i] == err)
+            return 1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// attempt 번째 retry 전 대기. backoff_us 부터 2배씩 늘어나며 backoff_max_us 에서 멈춤.
+//------------------------------------------------------------------------------
+static void retry_backoff (const struct i2c_retry_policy *policy, int attempt)
+{
+    struct timespec ts;
+    uint64_t us = policy->backoff_us;
+
+    if (!us)
+        return;
+
+    if (policy->backoff_max_us > 0) {
+        us <<= (attempt < 20) ? attempt : 20;
+        if (us > (uint64_t)policy->backoff_max_us)
+            us = policy->backoff_max_us;
+    }
+    ts.tv_sec  = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    while (nanosleep (&ts, &ts) && (errno == EINTR))
+        ;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// addr 에 적용할 policy. device policy 가 없으면 bus 기본 policy, 둘 다 없으면 NULL.
+//------------------------------------------------------------------------------
+const struct i2c_retry_policy *i2c_retry_policy (struct i2c_bus *bus, int addr)
+{
+    struct i2c_retry *retry = bus->retry;
+
+    if (retry == NULL)
+        return NULL;
+
+    if (retry->dev[addr & (I2C_BUS_ADDR_MAX - 1)].retries > 0)
+        return &retry->dev[addr & (I2C_BUS_ADDR_MAX - 1)];
+
+    return (retry->bus.retries > 0) ? &retry->bus : NULL;
+}
+
+//------------------------------------------------------------------------------
+// attempt (0 부터) 번째 시도가 실패한 뒤 호출. 다시 시도해야 하면 backoff 후 1.
+// errno 는 실패 원인을 유지함.
+//------------------------------------------------------------------------------
+int i2c_retry_next (struct i2c_bus *bus, const struct i2c_retry_policy *policy,
+                    int addr, int attempt)
+{
+    int err = errno;
+
+    if ((policy == NULL) || (attempt >= policy->retries) || !retry_errno_match (policy, err))
+        return 0;
+
+    i2c_stat_retry (bus, addr);
+    retry_backoff (policy, attempt);
+
+    errno = err;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void i2c_retry_free (struct i2c_bus *bus)
+{
+    free (bus->retry);
+    bus->retry = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// retry policy 설정. device_addr -1 은 bus 기본값, policy NULL 은 해제.
+// probe (i2c_probe) 는 device 유무 확인이므로 retry 하지 않음. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_retry_set (int fd, int device_addr, const struct i2c_retry_policy *policy)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_retry_policy *dst;
+
+    if ((bus == NULL) || (device_addr < -1) || (device_addr >= I2C_BUS_ADDR_MAX))
+        return -1;
+    if (policy && ((policy->retries < 0) || (policy->backoff_us < 0)))
+        return -1;
+
+    if (bus->retry == NULL) {
+        if (policy == NULL)
+            return 0;
+        if ((bus->retry = calloc (1, sizeof(struct i2c_retry))) == NULL) {
+            fprintf (stderr, "%s : memory allocation error\n", __func__);
+            return -1;
+        }
+    }
+    dst = (device_addr < 0) ? &bus->retry->bus : &bus->retry->dev[device_addr];
+
+    if (policy == NULL)
+        memset (dst, 0, sizeof(struct i2c_retry_policy));
+    else
+        *dst = *policy;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
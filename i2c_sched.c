@@ -0,0 +1,506 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_sched.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Periodic register sampling scheduler (coalesced block reads).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "lib_i2c.h"
+#include "i2c_sched.h"
+#include "i2c_bus.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+// job 은 deadline 의 tick 에 해당하는 wheel slot 에 deadline 순서로 연결됨.
+// 같은 slot 에는 다음 바퀴의 job 도 있을 수 있으나 정렬되어 있으므로 앞에서부터만 확인.
+// 주기는 period 의 배수 시점 (next_ns) 에 맞추고 deadline 은 그 시점을 tick 경계로 올림하므로
+// 같은 주기 (또는 경계가 겹치는 주기) 의 job 은 add 시점과 관계없이 같은 tick 에 실행됨.
+//------------------------------------------------------------------------------
+struct i2c_sched_job {
+    int         used;
+    int         addr;
+    int         reg;
+    int         len;
+    uint64_t    period_ns;
+    /* 주기상의 sample 시점과 실제 실행 시점 (tick 경계) */
+    uint64_t    next_ns;
+    uint64_t    deadline;
+    i2c_sched_cb cb;
+    void        *arg;
+    struct i2c_sched_stat   stat;
+    struct i2c_sched_job    *next;
+};
+
+/* 같은 device 의 연속된 register 범위 (job 여러개를 하나의 read 로) */
+struct i2c_sched_span {
+    int         addr;
+    int         reg;
+    int         len;
+    int         ret;
+    uint8_t     buf[I2C_SCHED_SPAN_MAX];
+};
+
+struct i2c_sched {
+    int                 fd;
+    uint64_t            tick_ns;
+    uint64_t            cur_tick;
+    struct i2c_sched_job    job[I2C_SCHED_JOB_MAX];
+    struct i2c_sched_job    *wheel[I2C_SCHED_WHEEL_SIZE];
+    struct i2c_sched_stat   total;
+    /* 한번의 poll 에서 읽는 span (device 1개분) */
+    struct i2c_sched_span   span[I2C_SCHED_JOB_MAX];
+    /* add/remove/poll 보호 및 thread 깨우기 */
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    pthread_t           thread;
+    int                 running;
+    int                 stop;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static uint64_t tick_align      (struct i2c_sched *sched, uint64_t ns);
+static void     wheel_insert    (struct i2c_sched *sched, struct i2c_sched_job *job);
+static void     wheel_remove    (struct i2c_sched *sched, struct i2c_sched_job *job);
+static int      wheel_collect   (struct i2c_sched *sched, uint64_t now, struct i2c_sched_job **due);
+static int      job_cmp         (const void *a, const void *b);
+static void     sched_read      (struct i2c_sched *sched, struct i2c_sched_span *span, int cnt);
+static void     sched_run_due   (struct i2c_sched *sched, struct i2c_sched_job **due, int cnt);
+static void     *sched_thread   (void *arg);
+
+//------------------------------------------------------------------------------
+struct i2c_sched *i2c_sched_create (int fd, uint32_t tick_us);
+void     i2c_sched_destroy  (struct i2c_sched *sched);
+int      i2c_sched_add      (struct i2c_sched *sched, int addr, int reg, int len,
+                             uint32_t period_us, i2c_sched_cb cb, void *arg);
+int      i2c_sched_remove   (struct i2c_sched *sched, int id);
+int64_t  i2c_sched_poll     (struct i2c_sched *sched);
+int      i2c_sched_start    (struct i2c_sched *sched);
+int      i2c_sched_stop     (struct i2c_sched *sched);
+int      i2c_sched_stat     (struct i2c_sched *sched, int id, struct i2c_sched_stat *stat);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static uint64_t tick_align (struct i2c_sched *sched, uint64_t ns)
+{
+    return (ns + sched->tick_ns - 1) / sched->tick_ns * sched->tick_ns;
+}
+
+//------------------------------------------------------------------------------
+static void wheel_insert (struct i2c_sched *sched, struct i2c_sched_job *job)
+{
+    struct i2c_sched_job **p;
+
+    p = &sched->wheel[(job->deadline / sched->tick_ns) % I2C_SCHED_WHEEL_SIZE];
+    while ((*p != NULL) && ((*p)->deadline <= job->deadline))
+        p = &(*p)->next;
+
+    job->next = *p;
+    *p = job;
+}
+
+//------------------------------------------------------------------------------
+static void wheel_remove (struct i2c_sched *sched, struct i2c_sched_job *job)
+{
+    struct i2c_sched_job **p;
+
+    p = &sched->wheel[(job->deadline / sched->tick_ns) % I2C_SCHED_WHEEL_SIZE];
+    while ((*p != NULL) && (*p != job))
+        p = &(*p)->next;
+
+    if (*p != NULL)
+        *p = job->next;
+    job->next = NULL;
+}
+
+//------------------------------------------------------------------------------
+// 마지막 확인한 tick 부터 현재 tick 까지의 slot 에서 deadline 이 지난 job 을 꺼냄.
+// deadline 은 tick 경계이므로 현재 tick slot 의 이번 바퀴 job 은 모두 한번에 꺼내짐.
+// 한 바퀴 이상 늦었으면 모든 slot 을 한번씩만 확인.
+//------------------------------------------------------------------------------
+static int wheel_collect (struct i2c_sched *sched, uint64_t now, struct i2c_sched_job **due)
+{
+    uint64_t tick, now_tick = now / sched->tick_ns;
+    struct i2c_sched_job **slot;
+    int cnt = 0;
+
+    if (now_tick - sched->cur_tick >= I2C_SCHED_WHEEL_SIZE)
+        sched->cur_tick = now_tick - I2C_SCHED_WHEEL_SIZE + 1;
+
+    for (tick = sched->cur_tick; tick <= now_tick; tick++) {
+        slot = &sched->wheel[tick % I2C_SCHED_WHEEL_SIZE];
+        while ((*slot != NULL) && ((*slot)->deadline <= now)) {
+            due[cnt++] = *slot;
+            *slot = (*slot)->next;
+            due[cnt - 1]->next = NULL;
+        }
+    }
+    /* 현재 tick 까지 확인 완료 (이후 들어오는 job 의 deadline 은 다음 tick 이후) */
+    sched->cur_tick = now_tick;
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+static int job_cmp (const void *a, const void *b)
+{
+    const struct i2c_sched_job *x = *(struct i2c_sched_job * const *)a;
+    const struct i2c_sched_job *y = *(struct i2c_sched_job * const *)b;
+
+    if (x->addr != y->addr)
+        return x->addr - y->addr;
+    return x->reg - y->reg;
+}
+
+//------------------------------------------------------------------------------
+// 같은 device 의 span 들은 I2C 지원 bus 이면 하나의 combined transfer
+// (reg write + repeated START + read 반복)로, 아니면 span 마다 block read 로 읽음.
+// block read 는 slave address 를 바꾸므로 끝난 후 application 의 address 로 되돌림.
+//------------------------------------------------------------------------------
+static void sched_read (struct i2c_sched *sched, struct i2c_sched_span *span, int cnt)
+{
+    struct i2c_bus *bus = i2c_bus_get (sched->fd);
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t regs[I2C_RDWR_IOCTL_MAX_MSGS / 2];
+    int i, ret, addr;
+
+    if (bus && (bus->funcs & I2C_FUNC_I2C) && (cnt * 2 <= I2C_RDWR_IOCTL_MAX_MSGS)) {
+        for (i = 0; i < cnt; i++) {
+            regs[i] = span[i].reg;
+            msgs[i * 2].addr      = span[i].addr;
+            msgs[i * 2].flags     = 0;
+            msgs[i * 2].len       = 1;
+            msgs[i * 2].buf       = &regs[i];
+            msgs[i * 2 + 1].addr  = span[i].addr;
+            msgs[i * 2 + 1].flags = I2C_M_RD;
+            msgs[i * 2 + 1].len   = span[i].len;
+            msgs[i * 2 + 1].buf   = span[i].buf;
+        }
+        ret = (i2c_transfer (sched->fd, msgs, cnt * 2) == cnt * 2) ? 0 : -1;
+        for (i = 0; i < cnt; i++)
+            span[i].ret = ret;
+        sched->total.transactions++;
+        return;
+    }
+
+    addr = bus ? bus->addr : 0;
+    for (i = 0; i < cnt; i++) {
+        span[i].ret = -1;
+        if (!i2c_set_addr (sched->fd, span[i].addr) &&
+            (i2c_read_block (sched->fd, span[i].reg, span[i].buf, span[i].len) == span[i].len))
+            span[i].ret = 0;
+        sched->total.transactions += (span[i].len + I2C_SMBUS_BLOCK_MAX - 1) / I2C_SMBUS_BLOCK_MAX;
+    }
+    if (bus && (bus->addr != addr))
+        i2c_set_addr (sched->fd, addr);
+}
+
+//------------------------------------------------------------------------------
+// due job 을 device 별로 묶어서 읽고 callback 호출 후 다음 deadline 으로 다시 등록.
+// 주기 시점은 고정 주기(next_ns += period)로 증가하므로 실행 시간에 따른 drift 가 없음.
+//------------------------------------------------------------------------------
+static void sched_run_due (struct i2c_sched *sched, struct i2c_sched_job **due, int cnt)
+{
+    struct i2c_sched_span *span = sched->span;
+    struct i2c_sched_sample sample;
+    struct i2c_sched_job *job;
+    int i, j, first, nspan, s;
+    uint64_t now, late, skip;
+
+    qsort (due, cnt, sizeof(struct i2c_sched_job *), job_cmp);
+
+    for (first = 0; first < cnt; first = i) {
+        /* 같은 device 의 job 을 register 순서로 span 에 합침 */
+        for (i = first, nspan = 0; (i < cnt) && (due[i]->addr == due[first]->addr); i++) {
+            job = due[i];
+            s = nspan - 1;
+            if ((nspan > 0) && (job->reg <= span[s].reg + span[s].len + I2C_SCHED_MERGE_GAP) &&
+                (job->reg + job->len - span[s].reg <= I2C_SCHED_SPAN_MAX)) {
+                if (job->reg + job->len > span[s].reg + span[s].len)
+                    span[s].len = job->reg + job->len - span[s].reg;
+                continue;
+            }
+            span[nspan].addr = job->addr;
+            span[nspan].reg  = job->reg;
+            span[nspan].len  = job->len;
+            nspan++;
+        }
+        sched_read (sched, span, nspan);
+        now = gpio_delay_now ();
+
+        for (j = first, s = 0; j < i; j++) {
+            job = due[j];
+            while ((job->reg < span[s].reg) || (job->reg + job->len > span[s].reg + span[s].len))
+                s++;
+
+            late = (now > job->deadline) ? now - job->deadline : 0;
+            job->stat.samples++;
+            if (span[s].ret)
+                job->stat.errors++;
+            if (late > job->stat.late_max_ns)
+                job->stat.late_max_ns = late;
+
+            sample.id          = job - sched->job;
+            sample.addr        = job->addr;
+            sample.reg         = job->reg;
+            sample.ret         = span[s].ret;
+            sample.buf         = &span[s].buf[job->reg - span[s].reg];
+            sample.len         = job->len;
+            sample.deadline_ns = job->deadline;
+            sample.sample_ns   = now;
+            sample.missed      = job->stat.missed;
+            if (job->cb)
+                job->cb (&sample, job->arg);
+
+            /* 다음 주기 시점이 이미 지났으면 그 주기들은 놓친 것으로 처리 */
+            job->next_ns += job->period_ns;
+            if (job->next_ns <= now) {
+                skip = (now - job->next_ns) / job->period_ns + 1;
+                job->stat.missed += skip;
+                job->next_ns     += skip * job->period_ns;
+            }
+            job->deadline = tick_align (sched, job->next_ns);
+            wheel_insert (sched, job);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static void *sched_thread (void *arg)
+{
+    struct i2c_sched *sched = arg;
+    struct timespec ts;
+    int64_t wait_ns;
+    uint64_t wake;
+
+    pthread_mutex_lock (&sched->lock);
+    while (!sched->stop) {
+        pthread_mutex_unlock (&sched->lock);
+        wait_ns = i2c_sched_poll (sched);
+        pthread_mutex_lock (&sched->lock);
+
+        if (sched->stop)
+            break;
+        /* job 이 없으면 add 또는 stop 까지 대기 */
+        if (wait_ns < 0) {
+            pthread_cond_wait (&sched->cond, &sched->lock);
+            continue;
+        }
+        wake = gpio_delay_now () + wait_ns;
+        ts.tv_sec  = wake / 1000000000ull;
+        ts.tv_nsec = wake % 1000000000ull;
+        pthread_cond_timedwait (&sched->cond, &sched->lock, &ts);
+    }
+    pthread_mutex_unlock (&sched->lock);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// tick_us 는 timer wheel 의 tick (0 이면 I2C_SCHED_TICK_US). 실패시 NULL.
+//------------------------------------------------------------------------------
+struct i2c_sched *i2c_sched_create (int fd, uint32_t tick_us)
+{
+    struct i2c_sched *sched;
+    pthread_condattr_t attr;
+
+    if (i2c_bus_get (fd) == NULL)
+        return NULL;
+
+    if ((sched = calloc (1, sizeof(struct i2c_sched))) == NULL)
+        return NULL;
+
+    gpio_delay_init ();
+    sched->fd       = fd;
+    sched->tick_ns  = (uint64_t)(tick_us ? tick_us : I2C_SCHED_TICK_US) * 1000;
+    sched->cur_tick = gpio_delay_now () / sched->tick_ns;
+
+    pthread_mutex_init (&sched->lock, NULL);
+    pthread_condattr_init (&attr);
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+    pthread_cond_init (&sched->cond, &attr);
+    pthread_condattr_destroy (&attr);
+    return sched;
+}
+
+//------------------------------------------------------------------------------
+void i2c_sched_destroy (struct i2c_sched *sched)
+{
+    if (sched == NULL)
+        return;
+
+    i2c_sched_stop (sched);
+    pthread_mutex_destroy (&sched->lock);
+    pthread_cond_destroy (&sched->cond);
+    free (sched);
+}
+
+//------------------------------------------------------------------------------
+// addr 의 reg ~ reg + len - 1 (8bit register) 을 period_us 마다 읽어서 cb 호출.
+// sample 은 period_us 의 배수 시점 (tick 경계로 올림) 이므로 첫 sample 은 한 주기 이내.
+// 성공시 job id, 실패시 -1.
+// cb 는 poll (또는 scheduler thread) 안에서 호출되므로 add/remove 를 호출하면 안됨.
+//------------------------------------------------------------------------------
+int i2c_sched_add (struct i2c_sched *sched, int addr, int reg, int len,
+                   uint32_t period_us, i2c_sched_cb cb, void *arg)
+{
+    struct i2c_sched_job *job;
+    int id;
+
+    if ((sched == NULL) || !period_us || (len <= 0) || (len > I2C_SCHED_SPAN_MAX) ||
+        (reg < 0) || (reg + len > 256))
+        return -1;
+
+    pthread_mutex_lock (&sched->lock);
+    for (id = 0; id < I2C_SCHED_JOB_MAX; id++)
+        if (!sched->job[id].used)
+            break;
+
+    if (id == I2C_SCHED_JOB_MAX) {
+        pthread_mutex_unlock (&sched->lock);
+        return -1;
+    }
+    job = &sched->job[id];
+    memset (job, 0, sizeof(struct i2c_sched_job));
+    job->used      = 1;
+    job->addr      = addr;
+    job->reg       = reg;
+    job->len       = len;
+    job->period_ns = (uint64_t)period_us * 1000;
+    job->next_ns   = (gpio_delay_now () / job->period_ns + 1) * job->period_ns;
+    job->deadline  = tick_align (sched, job->next_ns);
+    job->cb        = cb;
+    job->arg       = arg;
+    wheel_insert (sched, job);
+
+    pthread_cond_signal (&sched->cond);
+    pthread_mutex_unlock (&sched->lock);
+    return id;
+}
+
+//------------------------------------------------------------------------------
+int i2c_sched_remove (struct i2c_sched *sched, int id)
+{
+    if ((sched == NULL) || (id < 0) || (id >= I2C_SCHED_JOB_MAX))
+        return -1;
+
+    pthread_mutex_lock (&sched->lock);
+    if (!sched->job[id].used) {
+        pthread_mutex_unlock (&sched->lock);
+        return -1;
+    }
+    wheel_remove (sched, &sched->job[id]);
+    sched->job[id].used = 0;
+    pthread_mutex_unlock (&sched->lock);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// deadline 이 지난 job 을 실행. 다음 deadline 까지 남은 시간(ns) 반환, job 이 없으면 -1.
+// application loop 에서 직접 호출하거나 i2c_sched_start 의 thread 에서 사용.
+//------------------------------------------------------------------------------
+int64_t i2c_sched_poll (struct i2c_sched *sched)
+{
+    struct i2c_sched_job *due[I2C_SCHED_JOB_MAX];
+    uint64_t now, next = UINT64_MAX;
+    int i, cnt;
+
+    if (sched == NULL)
+        return -1;
+
+    pthread_mutex_lock (&sched->lock);
+    if ((cnt = wheel_collect (sched, gpio_delay_now (), due)) > 0)
+        sched_run_due (sched, due, cnt);
+
+    for (i = 0; i < I2C_SCHED_JOB_MAX; i++)
+        if (sched->job[i].used && (sched->job[i].deadline < next))
+            next = sched->job[i].deadline;
+    pthread_mutex_unlock (&sched->lock);
+
+    if (next == UINT64_MAX)
+        return -1;
+
+    now = gpio_delay_now ();
+    return (next > now) ? (int64_t)(next - now) : 0;
+}
+
+//------------------------------------------------------------------------------
+// scheduler thread 시작. 이후 poll 은 호출하지 않아야 함. 성공시 0.
+//------------------------------------------------------------------------------
+int i2c_sched_start (struct i2c_sched *sched)
+{
+    if ((sched == NULL) || sched->running)
+        return -1;
+
+    sched->stop = 0;
+    if (pthread_create (&sched->thread, NULL, sched_thread, sched)) {
+        fprintf (stderr, "%s : scheduler thread create error\n", __func__);
+        return -1;
+    }
+    sched->running = 1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_sched_stop (struct i2c_sched *sched)
+{
+    if ((sched == NULL) || !sched->running)
+        return -1;
+
+    pthread_mutex_lock (&sched->lock);
+    sched->stop = 1;
+    pthread_cond_signal (&sched->cond);
+    pthread_mutex_unlock (&sched->lock);
+
+    pthread_join (sched->thread, NULL);
+    sched->running = 0;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// id 의 통계 (id 가 -1 이면 전체 합계와 bus transaction 수). 성공시 0.
+//------------------------------------------------------------------------------
+int i2c_sched_stat (struct i2c_sched *sched, int id, struct i2c_sched_stat *stat)
+{
+    int i;
+
+    if ((sched == NULL) || (stat == NULL) || (id < -1) || (id >= I2C_SCHED_JOB_MAX))
+        return -1;
+
+    pthread_mutex_lock (&sched->lock);
+    if (id >= 0) {
+        *stat = sched->job[id].stat;
+        stat->transactions = 0;
+    } else {
+        *stat = sched->total;
+        for (i = 0; i < I2C_SCHED_JOB_MAX; i++) {
+            if (!sched->job[i].used)
+                continue;
+            stat->samples += sched->job[i].stat.samples;
+            stat->missed  += sched->job[i].stat.missed;
+            stat->errors  += sched->job[i].stat.errors;
+            if (sched->job[i].stat.late_max_ns > stat->late_max_ns)
+                stat->late_max_ns = sched->job[i].stat.late_max_ns;
+        }
+    }
+    pthread_mutex_unlock (&sched->lock);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
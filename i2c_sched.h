@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_sched.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Periodic register sampling scheduler (coalesced block reads).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_SCHED_H__
+#define __I2C_SCHED_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+#define I2C_SCHED_JOB_MAX       64
+/* timer wheel slot 수와 기본 tick (deadline 정밀도) */
+#define I2C_SCHED_WHEEL_SIZE    256
+#define I2C_SCHED_TICK_US       1000
+/* 이 byte 수 이하로 떨어진 register 범위는 하나의 read 로 합침 */
+#define I2C_SCHED_MERGE_GAP     4
+/* 합쳐진 read 1개의 최대 크기 */
+#define I2C_SCHED_SPAN_MAX      256
+
+//------------------------------------------------------------------------------
+struct i2c_sched_sample {
+    int         id;
+    int         addr;
+    int         reg;
+    /* 성공시 0, 실패시 -1 (buf 내용은 의미 없음) */
+    int         ret;
+    const uint8_t *buf;
+    int         len;
+    /* 예정 시간, 실제 read 완료 시간 (CLOCK_MONOTONIC ns) */
+    uint64_t    deadline_ns;
+    uint64_t    sample_ns;
+    /* 지금까지 놓친(건너뛴) 주기 수 */
+    uint32_t    missed;
+};
+
+/* job id 가 -1 이면 전체 합계 (transactions 는 전체에서만 의미 있음) */
+struct i2c_sched_stat {
+    uint32_t    samples;
+    uint32_t    missed;
+    uint32_t    errors;
+    uint64_t    late_max_ns;
+    uint32_t    transactions;
+};
+
+typedef void (*i2c_sched_cb) (const struct i2c_sched_sample *sample, void *arg);
+
+//------------------------------------------------------------------------------
+// scheduler 는 application 과 같은 fd 를 사용함. i2c_sched_start 후에는 scheduler thread 와
+// application 의 transaction 이 섞일 수 있으므로 같은 fd 의 호출은 application 에서 맞춰야 함.
+// I2C_FUNC_I2C 가 없는 bus 는 job 마다 i2c_set_addr 로 slave address 를 바꾸고 읽은 후
+// 원래 address 로 되돌리지만, 그 사이의 application 호출은 job 의 address 로 전송됨.
+//------------------------------------------------------------------------------
+struct i2c_sched;
+
+extern struct i2c_sched *i2c_sched_create (int fd, uint32_t tick_us);
+extern void     i2c_sched_destroy   (struct i2c_sched *sched);
+extern int      i2c_sched_add       (struct i2c_sched *sched, int addr, int reg, int len,
+                                     uint32_t period_us, i2c_sched_cb cb, void *arg);
+extern int      i2c_sched_remove    (struct i2c_sched *sched, int id);
+extern int64_t  i2c_sched_poll      (struct i2c_sched *sched);
+extern int      i2c_sched_start     (struct i2c_sched *sched);
+extern int      i2c_sched_stop      (struct i2c_sched *sched);
+extern int      i2c_sched_stat      (struct i2c_sched *sched, int id, struct i2c_sched_stat *stat);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_SCHED_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,520 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_sim.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief In-process simulated I2C bus (virtual devices) for test/benchmark.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <ctype.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+
+#include "i2c_sim.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+#define I2C_SIM_SEED_DEFAULT    1
+
+//------------------------------------------------------------------------------
+// 가상 device. message 단위로 write/read 함수가 호출되며, write message 의
+// 앞부분(addr_bytes)은 내부 pointer 설정, 나머지는 pointer 위치부터 data 로 처리.
+//------------------------------------------------------------------------------
+struct i2c_sim_dev;
+
+struct i2c_sim_type {
+    const char  *name;
+    int     (*init)     (struct i2c_sim_dev *dev);
+    void    (*write)    (struct i2c_sim_dev *dev, const uint8_t *buf, int len);
+    void    (*read)     (struct i2c_sim_dev *dev, uint8_t *buf, int len);
+};
+
+struct i2c_sim_dev {
+    const struct i2c_sim_type *type;
+    int         addr;
+    /* transaction 당 latency, address NACK 확률(%) */
+    uint32_t    latency_ns;
+    int         nack_pct;
+    uint8_t     *mem;
+    uint32_t    size;
+    /* EEPROM : page 크기, write cycle 시간, write cycle 종료 시점 */
+    uint32_t    page;
+    uint32_t    twr_ns;
+    uint64_t    busy_until;
+    /* register/memory pointer 크기(1 or 2 byte) 와 현재 값 */
+    int         addr_bytes;
+    uint32_t    ptr;
+    /* sensor sample 갱신 횟수 */
+    uint32_t    samples;
+};
+
+struct i2c_sim {
+    struct i2c_sim_dev  dev[I2C_SIM_DEV_MAX];
+    int                 dev_cnt;
+    unsigned int        seed;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      regmap_init     (struct i2c_sim_dev *dev);
+static void     regmap_write    (struct i2c_sim_dev *dev, const uint8_t *buf, int len);
+static void     regmap_read     (struct i2c_sim_dev *dev, uint8_t *buf, int len);
+static int      eeprom_init     (struct i2c_sim_dev *dev);
+static void     eeprom_write    (struct i2c_sim_dev *dev, const uint8_t *buf, int len);
+static void     eeprom_read     (struct i2c_sim_dev *dev, uint8_t *buf, int len);
+static void     sensor_write    (struct i2c_sim_dev *dev, const uint8_t *buf, int len);
+static void     sensor_read     (struct i2c_sim_dev *dev, uint8_t *buf, int len);
+
+static const struct i2c_sim_type *sim_type (const char *name);
+static struct i2c_sim_dev *sim_dev  (struct i2c_sim *sim, int addr);
+static int      sim_addr_ack    (struct i2c_sim *sim, struct i2c_sim_dev *dev);
+static int      sim_set_option  (struct i2c_sim_dev *dev, const char *key, const char *value);
+
+//------------------------------------------------------------------------------
+struct i2c_sim *i2c_sim_open    (const char *device_info);
+void     i2c_sim_close          (struct i2c_sim *sim);
+int      i2c_sim_transfer       (struct i2c_sim *sim, struct i2c_msg *msgs, int nmsgs);
+int      i2c_sim_smbus          (struct i2c_sim *sim, int addr, char rw, uint8_t command,
+                                 int size, union i2c_smbus_data *data);
+uint8_t *i2c_sim_mem            (struct i2c_sim *sim, int addr, uint32_t *size);
+
+//------------------------------------------------------------------------------
+// 새 device 는 이 table 에 추가.
+//------------------------------------------------------------------------------
+static const struct i2c_sim_type i2c_sim_types[] = {
+    /* 8bit register map (256 byte, auto-increment) */
+    { "REGMAP", regmap_init, regmap_write, regmap_read  },
+    /* 24Cxx EEPROM (page write, write cycle 동안 NACK) */
+    { "EEPROM", eeprom_init, eeprom_write, eeprom_read  },
+    /* LM75 style sensor (reg 0x00 ~ 0x01 : read 마다 갱신되는 16bit sample) */
+    { "SENSOR", regmap_init, sensor_write, sensor_read  },
+};
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int regmap_init (struct i2c_sim_dev *dev)
+{
+    dev->size       = I2C_SIM_REGMAP_SIZE;
+    dev->addr_bytes = 1;
+    return (dev->mem = calloc (1, dev->size)) != NULL;
+}
+
+//------------------------------------------------------------------------------
+static void regmap_write (struct i2c_sim_dev *dev, const uint8_t *buf, int len)
+{
+    int i;
+
+    if (len <= 0)
+        return;
+
+    dev->ptr = buf[0];
+    for (i = 1; i < len; i++, dev->ptr++)
+        dev->mem[dev->ptr % dev->size] = buf[i];
+}
+
+//------------------------------------------------------------------------------
+static void regmap_read (struct i2c_sim_dev *dev, uint8_t *buf, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++, dev->ptr++)
+        buf[i] = dev->mem[dev->ptr % dev->size];
+}
+
+//------------------------------------------------------------------------------
+// 256 byte 보다 크면 16bit memory address 사용 (24C32 이상)
+//------------------------------------------------------------------------------
+static int eeprom_init (struct i2c_sim_dev *dev)
+{
+    if (!dev->size)
+        dev->size = I2C_SIM_EEPROM_SIZE;
+    if (!dev->page)
+        dev->page = I2C_SIM_EEPROM_PAGE;
+
+    dev->addr_bytes = (dev->size > 256) ? 2 : 1;
+    if ((dev->mem = malloc (dev->size)) == NULL)
+        return 0;
+
+    /* erase 상태 */
+    memset (dev->mem, 0xFF, dev->size);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// page 경계를 넘는 data 는 같은 page 의 처음으로 돌아감 (실제 EEPROM 동작).
+//------------------------------------------------------------------------------
+static void eeprom_write (struct i2c_sim_dev *dev, const uint8_t *buf, int len)
+{
+    uint32_t base;
+    int i;
+
+    if (len <= 0)
+        return;
+
+    for (i = 0, dev->ptr = 0; (i < dev->addr_bytes) && (i < len); i++)
+        dev->ptr = (dev->ptr << 8) | buf[i];
+    dev->ptr %= dev->size;
+
+    if (len <= dev->addr_bytes)
+        return;
+
+    base = dev->ptr - (dev->ptr % dev->page);
+    for (; i < len; i++) {
+        dev->mem[dev->ptr] = buf[i];
+        dev->ptr = base + ((dev->ptr + 1 - base) % dev->page);
+    }
+    dev->busy_until = gpio_delay_now () + dev->twr_ns;
+}
+
+//------------------------------------------------------------------------------
+static void eeprom_read (struct i2c_sim_dev *dev, uint8_t *buf, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = dev->mem[dev->ptr];
+        dev->ptr = (dev->ptr + 1) % dev->size;
+    }
+}
+
+//------------------------------------------------------------------------------
+// sample register (0x00 ~ 0x01) 는 read only.
+//------------------------------------------------------------------------------
+static void sensor_write (struct i2c_sim_dev *dev, const uint8_t *buf, int len)
+{
+    uint8_t sample[2];
+
+    memcpy (sample, dev->mem, sizeof(sample));
+    regmap_write (dev, buf, len);
+    memcpy (dev->mem, sample, sizeof(sample));
+}
+
+//------------------------------------------------------------------------------
+// 25.0'C 에서 0.5'C 단위로 8 단계 증가하는 값 (LM75 format, MSB first)
+//------------------------------------------------------------------------------
+static void sensor_read (struct i2c_sim_dev *dev, uint8_t *buf, int len)
+{
+    uint16_t sample = (25 << 8) + ((dev->samples++ % 8) << 7);
+
+    dev->mem[0] = sample >> 8;
+    dev->mem[1] = sample & 0xFF;
+    regmap_read (dev, buf, len);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static const struct i2c_sim_type *sim_type (const char *name)
+{
+    int i;
+
+    for (i = 0; i < (int)(sizeof(i2c_sim_types) / sizeof(i2c_sim_types[0])); i++)
+        if (!strcasecmp (name, i2c_sim_types[i].name))
+            return &i2c_sim_types[i];
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static struct i2c_sim_dev *sim_dev (struct i2c_sim *sim, int addr)
+{
+    int i;
+
+    for (i = 0; i < sim->dev_cnt; i++)
+        if (sim->dev[i].addr == addr)
+            return &sim->dev[i];
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// device 없음, NACK injection, EEPROM write cycle 중이면 NACK(0).
+//------------------------------------------------------------------------------
+static int sim_addr_ack (struct i2c_sim *sim, struct i2c_sim_dev *dev)
+{
+    if (dev == NULL)
+        return 0;
+    if (dev->nack_pct && ((int)(rand_r (&sim->seed) % 100) < dev->nack_pct))
+        return 0;
+    if (dev->busy_until && (gpio_delay_now () < dev->busy_until))
+        return 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/* LAT(us), NACK(%), SIZE(byte), PAGE(byte), TWR(us) */
+//------------------------------------------------------------------------------
+static int sim_set_option (struct i2c_sim_dev *dev, const char *key, const char *value)
+{
+    long v = strtol (value, NULL, 0);
+
+    if (v < 0)
+        return 0;
+
+    if      (!strcasecmp (key, "LAT"))      dev->latency_ns = v * 1000;
+    else if (!strcasecmp (key, "NACK"))     dev->nack_pct   = (v > 100) ? 100 : v;
+    else if (!strcasecmp (key, "SIZE"))     dev->size       = v;
+    else if (!strcasecmp (key, "PAGE"))     dev->page       = v;
+    else if (!strcasecmp (key, "TWR"))      dev->twr_ns     = v * 1000;
+    else
+        return 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// device_info : "SIM[,<option>,<value>...],<type>,<addr>[,<option>,<value>...]..."
+//   type   : REGMAP, EEPROM, SENSOR
+//   option : LAT(us), NACK(%), SIZE, PAGE, TWR(us) 는 바로 앞의 device 에 적용.
+//            첫 device 앞의 option 은 이후 모든 device 의 기본값. SEED 는 NACK 난수 seed.
+//------------------------------------------------------------------------------
+struct i2c_sim *i2c_sim_open (const char *device_info)
+{
+    char sim_info[256], *p, *v, *save;
+    struct i2c_sim *sim;
+    struct i2c_sim_dev def, *dev = &def;
+    const struct i2c_sim_type *type;
+    int i, addr;
+
+    memset (sim_info, 0, sizeof(sim_info));
+    memset (&def, 0, sizeof(def));
+    strncpy (sim_info, device_info, sizeof(sim_info) -1);
+
+    if (((p = strtok_r (sim_info, ",", &save)) == NULL) || strcasecmp (p, "SIM"))
+        return NULL;
+
+    if ((sim = calloc (1, sizeof(struct i2c_sim))) == NULL)
+        return NULL;
+
+    sim->seed = I2C_SIM_SEED_DEFAULT;
+    gpio_delay_init ();
+
+    while ((p = strtok_r (NULL, ",", &save)) != NULL) {
+        if ((v = strtok_r (NULL, ",", &save)) == NULL)
+            goto err_out;
+
+        if ((type = sim_type (p)) != NULL) {
+            addr = strtol (v, NULL, 0);
+            if ((addr < 0x03) || (addr > 0x77) || sim_dev (sim, addr) ||
+                (sim->dev_cnt >= I2C_SIM_DEV_MAX)) {
+                printf ("%s error : device %s,%s\n", __func__, p, v);
+                goto err_out;
+            }
+            dev = &sim->dev[sim->dev_cnt++];
+            *dev = def;
+            dev->type = type;
+            dev->addr = addr;
+        }
+        else if (!strcasecmp (p, "SEED"))
+            sim->seed = strtoul (v, NULL, 0);
+        else if (!sim_set_option (dev, p, v)) {
+            printf ("%s error : unknown option %s,%s\n", __func__, p, v);
+            goto err_out;
+        }
+    }
+
+    /* option 이 모두 적용된 후 memory 할당 */
+    for (i = 0; i < sim->dev_cnt; i++) {
+        dev = &sim->dev[i];
+        if (!dev->type->init (dev)) {
+            printf ("%s error : %s(0x%02x) init failed\n", __func__, dev->type->name, dev->addr);
+            goto err_out;
+        }
+    }
+    return sim;
+
+err_out:
+    i2c_sim_close (sim);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+void i2c_sim_close (struct i2c_sim *sim)
+{
+    int i;
+
+    if (sim == NULL)
+        return;
+
+    for (i = 0; i < sim->dev_cnt; i++)
+        free (sim->dev[i].mem);
+    free (sim);
+}
+
+//------------------------------------------------------------------------------
+// device memory (test 에서 초기값 설정 또는 결과 확인용). 없으면 NULL.
+//------------------------------------------------------------------------------
+uint8_t *i2c_sim_mem (struct i2c_sim *sim, int addr, uint32_t *size)
+{
+    struct i2c_sim_dev *dev;
+
+    if ((sim == NULL) || ((dev = sim_dev (sim, addr)) == NULL))
+        return NULL;
+
+    if (size != NULL)
+        *size = dev->size;
+    return dev->mem;
+}
+
+//------------------------------------------------------------------------------
+// I2C_RDWR 와 동일한 combined transfer. 첫 message 의 device latency 를
+// transaction 마다 적용함. 성공시 전송한 message 수, 실패시 -1 (errno 설정).
+//------------------------------------------------------------------------------
+int i2c_sim_transfer (struct i2c_sim *sim, struct i2c_msg *msgs, int nmsgs)
+{
+    struct i2c_sim_dev *dev;
+    int i;
+
+    if ((sim == NULL) || (msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (((dev = sim_dev (sim, msgs[0].addr)) != NULL) && dev->latency_ns)
+        gpio_delay_ns (dev->latency_ns);
+
+    for (i = 0; i < nmsgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+
+        /* 10bit address 는 지원하지 않음 */
+        if (msg->flags & I2C_M_TEN) {
+            errno = EINVAL;
+            return -1;
+        }
+        dev = sim_dev (sim, msg->addr);
+        if (!sim_addr_ack (sim, dev)) {
+            if (!(msg->flags & I2C_M_IGNORE_NAK) || (dev == NULL)) {
+                errno = ENXIO;
+                return -1;
+            }
+        }
+        if (!(msg->flags & I2C_M_RD)) {
+            dev->type->write (dev, msg->buf, msg->len);
+            continue;
+        }
+        if (!msg->len)
+            continue;
+
+        /* SMBus block read : 첫 byte 가 이후 data 의 count */
+        if (msg->flags & I2C_M_RECV_LEN) {
+            dev->type->read (dev, msg->buf, 1);
+            if (!msg->buf[0] || (msg->buf[0] > I2C_SMBUS_BLOCK_MAX)) {
+                errno = EPROTO;
+                return -1;
+            }
+            msg->len += msg->buf[0];
+            dev->type->read (dev, &msg->buf[1], msg->len - 1);
+        }
+        else
+            dev->type->read (dev, msg->buf, msg->len);
+    }
+    return nmsgs;
+}
+
+//------------------------------------------------------------------------------
+// SMBus transaction 을 i2c message 로 변환 (kernel i2c_smbus_xfer_emulated 와 동일).
+// 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_sim_smbus (struct i2c_sim *sim, int addr, char rw, uint8_t command,
+                   int size, union i2c_smbus_data *data)
+{
+    uint8_t wbuf[I2C_SMBUS_BLOCK_MAX + 2], rbuf[I2C_SMBUS_BLOCK_MAX + 1];
+    struct i2c_msg msgs[2] = {
+        { .addr = addr, .flags = 0,         .len = 1, .buf = wbuf },
+        { .addr = addr, .flags = I2C_M_RD,  .len = 0, .buf = rbuf },
+    };
+    int nmsgs = rw ? 2 : 1, len = 0;
+
+    wbuf[0] = command;
+
+    switch (size) {
+        case I2C_SMBUS_QUICK:
+            msgs[0].len   = 0;
+            msgs[0].flags = rw ? I2C_M_RD : 0;
+            nmsgs = 1;
+            break;
+        case I2C_SMBUS_BYTE:
+            if (rw) {
+                /* receive byte : command 없이 read 만 */
+                msgs[0] = msgs[1];
+                msgs[0].len = 1;
+                nmsgs = 1;
+            }
+            break;
+        case I2C_SMBUS_BYTE_DATA:
+            if (rw) msgs[1].len = 1;
+            else {  msgs[0].len = 2;    wbuf[1] = data->byte;   }
+            break;
+        case I2C_SMBUS_WORD_DATA:
+            if (rw) msgs[1].len = 2;
+            else {
+                msgs[0].len = 3;
+                wbuf[1] = data->word & 0xFF;
+                wbuf[2] = data->word >> 8;
+            }
+            break;
+        case I2C_SMBUS_BLOCK_DATA:
+            if (rw) {
+                msgs[1].len   = 1;
+                msgs[1].flags |= I2C_M_RECV_LEN;
+            } else {
+                if (!data->block[0] || (data->block[0] > I2C_SMBUS_BLOCK_MAX))
+                    goto inval;
+                msgs[0].len = data->block[0] + 2;
+                memcpy (&wbuf[1], data->block, data->block[0] + 1);
+            }
+            break;
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+            if (!data->block[0] || (data->block[0] > I2C_SMBUS_BLOCK_MAX))
+                goto inval;
+            if (rw) msgs[1].len = data->block[0];
+            else {
+                msgs[0].len = data->block[0] + 1;
+                memcpy (&wbuf[1], &data->block[1], data->block[0]);
+            }
+            break;
+        default:
+            goto inval;
+    }
+    if (rw && (size != I2C_SMBUS_QUICK) && (data == NULL))
+        goto inval;
+
+    if (i2c_sim_transfer (sim, msgs, nmsgs) != nmsgs)
+        return -1;
+
+    if (!rw || (size == I2C_SMBUS_QUICK))
+        return 0;
+
+    switch (size) {
+        case I2C_SMBUS_BYTE:        data->byte = rbuf[0];                       break;
+        case I2C_SMBUS_BYTE_DATA:   data->byte = rbuf[0];                       break;
+        case I2C_SMBUS_WORD_DATA:   data->word = rbuf[0] | (rbuf[1] << 8);      break;
+        case I2C_SMBUS_BLOCK_DATA:  len = rbuf[0] + 1;
+                                    memcpy (data->block, rbuf, len);            break;
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+                                    memcpy (&data->block[1], rbuf, data->block[0]);
+                                    break;
+    }
+    return 0;
+
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
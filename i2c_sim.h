@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_sim.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief In-process simulated I2C bus (virtual devices) for test/benchmark.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_SIM_H__
+#define __I2C_SIM_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+//------------------------------------------------------------------------------
+#define I2C_SIM_DEV_MAX         16
+
+/* device 별 기본 memory 크기 (EEPROM 은 SIZE option 으로 변경) */
+#define I2C_SIM_REGMAP_SIZE     256
+#define I2C_SIM_EEPROM_SIZE     256
+#define I2C_SIM_EEPROM_PAGE     16
+
+//------------------------------------------------------------------------------
+/* simulated bus context (bus 마다 1개, device memory 는 bus 별로 독립) */
+struct i2c_sim;
+
+extern struct i2c_sim *i2c_sim_open (const char *device_info);
+extern void     i2c_sim_close       (struct i2c_sim *sim);
+extern int      i2c_sim_transfer    (struct i2c_sim *sim, struct i2c_msg *msgs, int nmsgs);
+extern int      i2c_sim_smbus       (struct i2c_sim *sim, int addr, char rw, uint8_t command,
+                                     int size, union i2c_smbus_data *data);
+extern uint8_t *i2c_sim_mem         (struct i2c_sim *sim, int addr, uint32_t *size);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_SIM_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
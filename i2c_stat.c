@@ -0,0 +1,298 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_stat.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Per bus / per device transaction counters and latency histograms.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------
+// slave address 별 counter. 기록은 relaxed atomic add 만 사용하므로 lock 이 없고
+// (async worker, scheduler thread 와 동시에 사용 가능) snapshot 은 counter 마다
+// 따로 읽으므로 counter 사이의 값은 약간 어긋날 수 있음.
+//------------------------------------------------------------------------------
+struct i2c_stat_dev {
+    atomic_uint_fast64_t    transactions;
+    atomic_uint_fast64_t    bytes;
+    atomic_uint_fast64_t    nacks;
+    atomic_uint_fast64_t    errors;
+    atomic_uint_fast64_t    retries;
+    atomic_uint_fast64_t    time_ns;
+    atomic_uint_fast64_t    hist[I2C_STAT_HIST_MAX];
+};
+
+struct i2c_stat {
+    struct i2c_stat_dev     dev[I2C_BUS_ADDR_MAX];
+};
+
+#define STAT_ADD(x, v)      atomic_fetch_add_explicit (&(x), (v), memory_order_relaxed)
+#define STAT_GET(x)         atomic_load_explicit      (&(x), memory_order_relaxed)
+#define STAT_CLR(x)         atomic_store_explicit     (&(x), 0, memory_order_relaxed)
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      stat_bucket     (uint64_t ns);
+static void     stat_sum        (struct i2c_stat_dev *dev, struct i2c_stat_info *info);
+
+//------------------------------------------------------------------------------
+int  i2c_stat_alloc     (struct i2c_bus *bus);
+void i2c_stat_free      (struct i2c_bus *bus);
+void i2c_stat_record    (struct i2c_bus *bus, int addr, uint64_t ns, int bytes, int ret);
+void i2c_stat_retry     (struct i2c_bus *bus, int addr);
+//------------------------------------------------------------------------------
+#endif  // #if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+
+int      i2c_stat_get       (int fd, int device_addr, struct i2c_stat_info *info);
+int      i2c_stat_reset     (int fd);
+uint64_t i2c_stat_percentile(const struct i2c_stat_info *info, double pct);
+int      i2c_stat_print     (int fd, FILE *fp);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+// bucket 0 : 512ns 미만, bucket b : 2^(b+8) ~ 2^(b+9) ns, 마지막 bucket 은 그 이상 전부.
+//------------------------------------------------------------------------------
+static int stat_bucket (uint64_t ns)
+{
+    int b;
+
+    if (ns < I2C_STAT_HIST_NS(0))
+        return 0;
+
+    b = (63 - __builtin_clzll (ns)) - 8;
+    return (b < I2C_STAT_HIST_MAX) ? b : I2C_STAT_HIST_MAX - 1;
+}
+
+//------------------------------------------------------------------------------
+static void stat_sum (struct i2c_stat_dev *dev, struct i2c_stat_info *info)
+{
+    int i;
+
+    info->transactions += STAT_GET(dev->transactions);
+    info->bytes        += STAT_GET(dev->bytes);
+    info->nacks        += STAT_GET(dev->nacks);
+    info->errors       += STAT_GET(dev->errors);
+    info->retries      += STAT_GET(dev->retries);
+    info->time_ns      += STAT_GET(dev->time_ns);
+    for (i = 0; i < I2C_STAT_HIST_MAX; i++)
+        info->hist[i]  += STAT_GET(dev->hist[i]);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int i2c_stat_alloc (struct i2c_bus *bus)
+{
+    if ((bus->stat = calloc (1, sizeof(struct i2c_stat))) == NULL) {
+        fprintf (stderr, "%s : memory allocation error\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void i2c_stat_free (struct i2c_bus *bus)
+{
+    free (bus->stat);
+    bus->stat = NULL;
+}
+
+//------------------------------------------------------------------------------
+// 소요 시간 ns 의 transaction 1개 기록 (lib_i2c.c 의 i2c_bus_* hook 에서 호출).
+// 실패는 errno 가 ENXIO/EREMOTEIO (address/data NACK) 이면 NACK, 그 외는 error.
+//------------------------------------------------------------------------------
+void i2c_stat_record (struct i2c_bus *bus, int addr, uint64_t ns, int bytes, int ret)
+{
+    struct i2c_stat_dev *dev;
+    int err = errno;
+
+    if (bus->stat == NULL)
+        return;
+
+    dev = &bus->stat->dev[addr & (I2C_BUS_ADDR_MAX - 1)];
+
+    STAT_ADD(dev->transactions, 1);
+    STAT_ADD(dev->time_ns, ns);
+    STAT_ADD(dev->hist[stat_bucket (ns)], 1);
+    if (ret < 0) {
+        if ((err == ENXIO) || (err == EREMOTEIO))
+            STAT_ADD(dev->nacks, 1);
+        else
+            STAT_ADD(dev->errors, 1);
+    }
+    else if (bytes > 0)
+        STAT_ADD(dev->bytes, bytes);
+}
+
+//------------------------------------------------------------------------------
+// 재시도한 transaction 수 (재시도 자체도 i2c_stat_record 로 따로 기록됨).
+//------------------------------------------------------------------------------
+void i2c_stat_retry (struct i2c_bus *bus, int addr)
+{
+    if (bus->stat != NULL)
+        STAT_ADD(bus->stat->dev[addr & (I2C_BUS_ADDR_MAX - 1)].retries, 1);
+}
+
+//------------------------------------------------------------------------------
+// device_addr 의 counter snapshot. device_addr 이 -1 이면 bus 전체 합계.
+// 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_stat_get (int fd, int device_addr, struct i2c_stat_info *info)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    int i;
+
+    if ((bus == NULL) || (bus->stat == NULL) || (info == NULL))
+        return -1;
+    if ((device_addr < -1) || (device_addr >= I2C_BUS_ADDR_MAX))
+        return -1;
+
+    memset (info, 0, sizeof(struct i2c_stat_info));
+    if (device_addr >= 0)
+        stat_sum (&bus->stat->dev[device_addr], info);
+    else
+        for (i = 0; i < I2C_BUS_ADDR_MAX; i++)
+            stat_sum (&bus->stat->dev[i], info);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_stat_reset (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    struct i2c_stat_dev *dev;
+    int i, j;
+
+    if ((bus == NULL) || (bus->stat == NULL))
+        return -1;
+
+    for (i = 0; i < I2C_BUS_ADDR_MAX; i++) {
+        dev = &bus->stat->dev[i];
+        STAT_CLR(dev->transactions);
+        STAT_CLR(dev->bytes);
+        STAT_CLR(dev->nacks);
+        STAT_CLR(dev->errors);
+        STAT_CLR(dev->retries);
+        STAT_CLR(dev->time_ns);
+        for (j = 0; j < I2C_STAT_HIST_MAX; j++)
+            STAT_CLR(dev->hist[j]);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// histogram 에서 pct(0 ~ 100) percentile 이 속한 bucket 의 상한 (ns). 기록이 없으면 0.
+//------------------------------------------------------------------------------
+uint64_t i2c_stat_percentile (const struct i2c_stat_info *info, double pct)
+{
+    uint64_t sum = 0, rank;
+    int i;
+
+    if ((info == NULL) || !info->transactions)
+        return 0;
+
+    rank = (uint64_t)(info->transactions * pct / 100.0 + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    for (i = 0; i < I2C_STAT_HIST_MAX - 1; i++) {
+        sum += info->hist[i];
+        if (sum >= rank)
+            break;
+    }
+    return I2C_STAT_HIST_NS(i);
+}
+
+//------------------------------------------------------------------------------
+// bus 합계와 device 별 counter 출력. 모두 NACK 인 address (scan 으로 찾지 못한 address)
+// 는 합계에만 포함. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_stat_print (int fd, FILE *fp)
+{
+    struct i2c_stat_info info;
+    int addr;
+
+    if (i2c_stat_get (fd, -1, &info))
+        return -1;
+
+    fprintf (fp, "\n%-6s %10s %10s %8s %8s %8s %10s %10s %10s\n",
+        "Addr", "Txn", "Bytes", "NACK", "Error", "Retry", "avg(us)", "p50(us)", "p99(us)");
+
+    for (addr = -1; addr < I2C_BUS_ADDR_MAX; addr++) {
+        if ((addr >= 0) && (i2c_stat_get (fd, addr, &info) || (info.transactions == info.nacks)))
+            continue;
+
+        if (addr < 0)
+            fprintf (fp, "%-6s ", "total");
+        else
+            fprintf (fp, "0x%02x   ", addr);
+
+        fprintf (fp, "%10llu %10llu %8llu %8llu %8llu %10.1f %10.1f %10.1f\n",
+            (unsigned long long)info.transactions, (unsigned long long)info.bytes,
+            (unsigned long long)info.nacks, (unsigned long long)info.errors,
+            (unsigned long long)info.retries,
+            info.transactions ? info.time_ns / 1000.0 / info.transactions : 0.0,
+            i2c_stat_percentile (&info, 50.0) / 1000.0,
+            i2c_stat_percentile (&info, 99.0) / 1000.0);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+#else   // #if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+// 통계 기능 제외 build. API 는 항상 실패.
+//------------------------------------------------------------------------------
+int i2c_stat_get (int fd, int device_addr, struct i2c_stat_info *info)
+{
+    (void)fd;   (void)device_addr;  (void)info;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int i2c_stat_reset (int fd)
+{
+    (void)fd;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+uint64_t i2c_stat_percentile (const struct i2c_stat_info *info, double pct)
+{
+    (void)info; (void)pct;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_stat_print (int fd, FILE *fp)
+{
+    (void)fd;   (void)fp;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+#endif  // #if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,287 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_stream.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Streaming image download (mmap, framing callback, pipelined transfers).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_i2c.h"
+#include "i2c_stream.h"
+#include "gpio_delay.h"
+
+//------------------------------------------------------------------------------
+// framing 이 끝난 chunk. worker 가 채우고 (ready) 호출 thread 가 전송 후 비움.
+//------------------------------------------------------------------------------
+struct stream_slot {
+    struct i2c_stream_chunk chunk;
+    struct i2c_msg  msgs[I2C_STREAM_MSG_MAX];
+    int             nmsgs;
+    uint8_t         *buf;
+};
+
+//------------------------------------------------------------------------------
+// slot ring : worker 는 head 에 framing, 호출 thread 는 tail 을 전송.
+//------------------------------------------------------------------------------
+struct stream {
+    const struct i2c_stream_cfg *cfg;
+    const uint8_t   *image;
+    size_t          size;
+    uint32_t        count;
+
+    struct stream_slot  *slot;
+    int             depth;
+    int             buf_len;
+    uint32_t        head;
+    uint32_t        tail;
+    /* 전송 종료 (worker 중단), head 의 chunk framing 실패 */
+    int             stop;
+    int             frame_err;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      stream_frame    (struct stream *st, struct stream_slot *s, uint32_t index);
+static void     *stream_worker  (void *arg);
+static void     stream_progress (struct i2c_stream_progress *p, uint64_t start_ns);
+
+//------------------------------------------------------------------------------
+int  i2c_stream_file    (int fd, const char *path, const struct i2c_stream_cfg *cfg,
+                         struct i2c_stream_progress *result);
+int  i2c_stream_buf     (int fd, const uint8_t *image, size_t size,
+                         const struct i2c_stream_cfg *cfg, struct i2c_stream_progress *result);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int stream_frame (struct stream *st, struct stream_slot *s, uint32_t index)
+{
+    const struct i2c_stream_cfg *cfg = st->cfg;
+    struct i2c_stream_chunk *c = &s->chunk;
+
+    c->index  = index;
+    c->offset = index * cfg->chunk;
+    c->data   = st->image + c->offset;
+    c->len    = ((st->size - c->offset) > cfg->chunk) ? cfg->chunk : (st->size - c->offset);
+    c->last   = (index == st->count - 1);
+
+    if (cfg->frame != NULL) {
+        s->nmsgs = cfg->frame (c, s->msgs, s->buf, st->buf_len, cfg->arg);
+        return ((s->nmsgs > 0) && (s->nmsgs <= I2C_STREAM_MSG_MAX)) ? 0 : -1;
+    }
+
+    /* write message 는 buf 를 바꾸지 않으므로 image 를 직접 전송 */
+    s->msgs[0].addr  = cfg->addr;
+    s->msgs[0].flags = 0;
+    s->msgs[0].len   = c->len;
+    s->msgs[0].buf   = (uint8_t *)c->data;
+    s->nmsgs = 1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 비어있는 slot 이 있으면 다음 chunk 를 framing (전송과 겹쳐서 실행).
+//------------------------------------------------------------------------------
+static void *stream_worker (void *arg)
+{
+    struct stream *st = arg;
+    uint32_t index;
+    int ret;
+
+    pthread_mutex_lock (&st->lock);
+    for (index = 0; index < st->count; index++) {
+        while (!st->stop && ((st->head - st->tail) >= (uint32_t)st->depth))
+            pthread_cond_wait (&st->cond, &st->lock);
+        if (st->stop)
+            break;
+        pthread_mutex_unlock (&st->lock);
+
+        ret = stream_frame (st, &st->slot[index % st->depth], index);
+
+        pthread_mutex_lock (&st->lock);
+        if (ret) {
+            st->frame_err = 1;
+            pthread_cond_broadcast (&st->cond);
+            break;
+        }
+        st->head++;
+        pthread_cond_broadcast (&st->cond);
+    }
+    pthread_mutex_unlock (&st->lock);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void stream_progress (struct i2c_stream_progress *p, uint64_t start_ns)
+{
+    p->elapsed_ns    = gpio_delay_now () - start_ns;
+    p->bytes_per_sec = p->elapsed_ns ? p->bytes * 1e9 / p->elapsed_ns : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// mmap 한 file 을 전송. page cache 를 그대로 사용하므로 image 를 heap 에 읽지 않음.
+//------------------------------------------------------------------------------
+int i2c_stream_file (int fd, const char *path, const struct i2c_stream_cfg *cfg,
+                     struct i2c_stream_progress *result)
+{
+    struct stat sb;
+    void *image;
+    int ffd, ret;
+
+    if ((ffd = open (path, O_RDONLY | O_CLOEXEC)) < 0) {
+        fprintf (stderr, "%s : %s : %s\n", __func__, path, strerror (errno));
+        return -1;
+    }
+    if (fstat (ffd, &sb) || (sb.st_size <= 0)) {
+        fprintf (stderr, "%s : %s : empty or unreadable\n", __func__, path);
+        close (ffd);
+        return -1;
+    }
+    image = mmap (NULL, sb.st_size, PROT_READ, MAP_PRIVATE, ffd, 0);
+    close (ffd);
+    if (image == MAP_FAILED) {
+        fprintf (stderr, "%s : %s : mmap error\n", __func__, path);
+        return -1;
+    }
+    madvise (image, sb.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+    ret = i2c_stream_buf (fd, image, sb.st_size, cfg, result);
+
+    munmap (image, sb.st_size);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// worker 가 depth 개의 chunk 를 미리 framing 하고 호출 thread 는 chunk 마다 combined
+// transfer 1회, done, progress 순서로 처리. bus 는 호출 thread 만 사용함.
+//------------------------------------------------------------------------------
+int i2c_stream_buf (int fd, const uint8_t *image, size_t size,
+                    const struct i2c_stream_cfg *cfg, struct i2c_stream_progress *result)
+{
+    struct i2c_stream_progress p;
+    struct stream_slot *s;
+    struct stream st;
+    pthread_t thread;
+    uint64_t start;
+    int i, ready, ret = 0;
+
+    if ((i2c_bus_get (fd) == NULL) || (image == NULL) || !size || (cfg == NULL) ||
+        !cfg->chunk || (cfg->chunk > I2C_STREAM_CHUNK_MAX) || ((uint64_t)size > UINT32_MAX)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset (&st, 0, sizeof(st));
+    st.cfg     = cfg;
+    st.image   = image;
+    st.size    = size;
+    st.count   = (size + cfg->chunk - 1) / cfg->chunk;
+    st.depth   = (cfg->depth > 0) ? cfg->depth : I2C_STREAM_DEPTH;
+    st.buf_len = cfg->chunk + I2C_STREAM_FRAME_EXTRA;
+
+    if ((st.slot = calloc (st.depth, sizeof(struct stream_slot))) == NULL)
+        goto err_alloc;
+    for (i = 0; i < st.depth; i++)
+        if ((cfg->frame != NULL) && ((st.slot[i].buf = malloc (st.buf_len)) == NULL))
+            goto err_alloc;
+
+    pthread_mutex_init (&st.lock, NULL);
+    pthread_cond_init  (&st.cond, NULL);
+
+    memset (&p, 0, sizeof(p));
+    p.total = size;
+    start   = gpio_delay_now ();
+
+    if (pthread_create (&thread, NULL, stream_worker, &st)) {
+        fprintf (stderr, "%s : thread create error\n", __func__);
+        ret = -1;
+        goto out;
+    }
+
+    while (p.chunks < st.count) {
+        pthread_mutex_lock (&st.lock);
+        while ((st.head == st.tail) && !st.frame_err)
+            pthread_cond_wait (&st.cond, &st.lock);
+        ready = (st.head != st.tail);
+        pthread_mutex_unlock (&st.lock);
+
+        /* framing 실패는 앞의 chunk 를 모두 보낸 후 보고 */
+        if (!ready) {
+            fprintf (stderr, "%s : chunk %u framing error\n", __func__, p.chunks);
+            errno = EINVAL;
+            ret = -1;
+            break;
+        }
+        s = &st.slot[st.tail % st.depth];
+
+        if (i2c_transfer (fd, s->msgs, s->nmsgs) != s->nmsgs) {
+            fprintf (stderr, "%s : chunk %u (0x%x) transfer error\n", __func__,
+                s->chunk.index, s->chunk.offset);
+            ret = -1;
+            break;
+        }
+        if ((cfg->done != NULL) && cfg->done (fd, &s->chunk, cfg->arg)) {
+            ret = -1;
+            break;
+        }
+        p.chunks++;
+        p.bytes += s->chunk.len;
+        stream_progress (&p, start);
+        if (cfg->progress != NULL)
+            cfg->progress (&p, cfg->arg);
+
+        pthread_mutex_lock (&st.lock);
+        st.tail++;
+        pthread_cond_broadcast (&st.cond);
+        pthread_mutex_unlock (&st.lock);
+    }
+
+    pthread_mutex_lock (&st.lock);
+    st.stop = 1;
+    pthread_cond_broadcast (&st.cond);
+    pthread_mutex_unlock (&st.lock);
+    pthread_join (thread, NULL);
+out:
+    stream_progress (&p, start);
+    if (result != NULL)
+        *result = p;
+
+    pthread_cond_destroy  (&st.cond);
+    pthread_mutex_destroy (&st.lock);
+    for (i = 0; i < st.depth; i++)
+        free (st.slot[i].buf);
+    free (st.slot);
+    return ret;
+
+err_alloc:
+    fprintf (stderr, "%s : memory allocation error\n", __func__);
+    if (st.slot != NULL)
+        for (i = 0; i < st.depth; i++)
+            free (st.slot[i].buf);
+    free (st.slot);
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
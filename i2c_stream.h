@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_stream.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Streaming image download (mmap, framing callback, pipelined transfers).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __I2C_STREAM_H__
+#define __I2C_STREAM_H__
+
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+//------------------------------------------------------------------------------
+/* chunk 1개를 보내는 combined transfer 의 최대 message 수 */
+#define I2C_STREAM_MSG_MAX      4
+/* framing callback 이 chunk 외에 사용할 수 있는 buffer 크기 (header, checksum) */
+#define I2C_STREAM_FRAME_EXTRA  64
+/* 미리 framing 해두는 chunk 수 (depth 0 일 때) */
+#define I2C_STREAM_DEPTH        4
+/* chunk 최대 크기 (kernel I2C_RDWR 의 message 당 최대 길이, i2c_msg.len 은 16bit) */
+#define I2C_STREAM_CHUNK_MAX    8192
+
+//------------------------------------------------------------------------------
+struct i2c_stream_chunk {
+    uint32_t        index;
+    /* image 안의 위치와 data (mmap 된 image 를 직접 가리킴, 복사 안함) */
+    uint32_t        offset;
+    const uint8_t   *data;
+    uint32_t        len;
+    /* 마지막 chunk 이면 1 */
+    int             last;
+};
+
+struct i2c_stream_progress {
+    uint64_t        bytes;
+    uint64_t        total;
+    uint32_t        chunks;
+    uint64_t        elapsed_ns;
+    /* 시작부터의 평균 전송 속도 */
+    double          bytes_per_sec;
+};
+
+//------------------------------------------------------------------------------
+// frame : chunk 를 보낼 message 를 msgs 에 작성하고 message 수를 돌려줌 (실패시 -1).
+//         header/checksum 등은 buf (buf_len = chunk + I2C_STREAM_FRAME_EXTRA byte) 에 만들고,
+//         data 를 그대로 보내는 message 는 chunk->data 를 직접 가리켜도 됨.
+//         worker thread 에서 전송중인 chunk 보다 앞서 호출됨.
+//         NULL 이면 cfg->addr 로 data 만 write 하는 message 1개 (복사 안함).
+// done   : chunk 전송 후 호출 (bootloader 상태 확인 등, 선택). 0 이 아니면 중단.
+// progress : chunk 전송 후 호출 (선택).
+// done/progress 는 i2c_stream_* 를 호출한 thread 에서 실행되므로 같은 fd 사용 가능.
+//------------------------------------------------------------------------------
+struct i2c_stream_cfg {
+    /* 7bit slave address */
+    int             addr;
+    /* chunk 크기 (byte, 1 ~ I2C_STREAM_CHUNK_MAX) */
+    uint32_t        chunk;
+    /* 미리 framing 해두는 chunk 수 (0 : I2C_STREAM_DEPTH) */
+    int             depth;
+
+    int     (*frame)    (const struct i2c_stream_chunk *chunk, struct i2c_msg *msgs,
+                         uint8_t *buf, int buf_len, void *arg);
+    int     (*done)     (int fd, const struct i2c_stream_chunk *chunk, void *arg);
+    void    (*progress) (const struct i2c_stream_progress *progress, void *arg);
+    void            *arg;
+};
+
+//------------------------------------------------------------------------------
+// image (file 은 mmap, 4GB 까지) 를 chunk 단위로 전송. result 가 있으면 최종 진행 상태 저장.
+// 성공시 0, 실패시 -1 (실패한 chunk 까지의 result).
+//------------------------------------------------------------------------------
+extern int  i2c_stream_file     (int fd, const char *path, const struct i2c_stream_cfg *cfg,
+                                 struct i2c_stream_progress *result);
+extern int  i2c_stream_buf      (int fd, const uint8_t *image, size_t size,
+                                 const struct i2c_stream_cfg *cfg,
+                                 struct i2c_stream_progress *result);
+
+//------------------------------------------------------------------------------
+#endif  // __I2C_STREAM_H__
+//------------------------------------------------------------------------------
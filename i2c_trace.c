@@ -0,0 +1,495 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_trace.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Lock-free transaction trace ring buffer and post-mortem dump.
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_TRACE__)
+//------------------------------------------------------------------------------
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------
+// 모든 bus 가 공유하는 ring. 기록은 head 의 atomic add 로 slot 을 얻은 뒤 seq 를 0 으로
+// 만들고 (기록중) entry 를 채운 다음 seq 를 기록 번호로 바꿈 (release). 읽는 쪽은 seq 가
+// 기록 번호와 같고 복사 전후로 바뀌지 않은 slot 만 사용하므로 lock 이 필요 없음.
+// ring 이 한바퀴 돌면 오래된 entry 부터 덮어씀.
+//------------------------------------------------------------------------------
+struct i2c_trace_slot {
+    atomic_uint_fast64_t    seq;
+    struct i2c_trace_entry  e;
+};
+
+struct i2c_trace {
+    atomic_uint_fast64_t    head;
+    atomic_int              enable;
+    struct i2c_trace_slot   slot[I2C_TRACE_MAX];
+};
+
+static struct i2c_trace Trace = { .enable = 1 };
+
+/* signal 발생시 dump 할 file */
+static char TracePath[256];
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static struct i2c_trace_slot *trace_claim (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns,
+                                           int type, int ret, uint64_t *seq);
+static void     trace_commit    (struct i2c_trace_slot *slot, uint64_t seq);
+static int      trace_read      (uint64_t idx, struct i2c_trace_entry *e);
+static char     *fmt_str        (char *p, const char *s, int width);
+static char     *fmt_dec        (char *p, int64_t v, int width, char fill);
+static char     *fmt_hex        (char *p, uint32_t v, int digits);
+static int      trace_format    (const struct i2c_trace_entry *e, char *line);
+static void     trace_signal_handler (int signo);
+
+//------------------------------------------------------------------------------
+void i2c_trace_smbus    (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, char rw,
+                         uint8_t command, int size, const union i2c_smbus_data *data, int ret);
+void i2c_trace_transfer (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns,
+                         const struct i2c_msg *msgs, int nmsgs, int ret);
+void i2c_trace_probe    (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, int addr, int ret);
+//------------------------------------------------------------------------------
+#endif  // #if !defined (__LIB_I2C_NO_TRACE__)
+//------------------------------------------------------------------------------
+
+int  i2c_trace_enable   (int enable);
+void i2c_trace_clear    (void);
+int  i2c_trace_snapshot (struct i2c_trace_entry *buf, int max);
+int  i2c_trace_dump     (int fd);
+int  i2c_trace_dump_file(const char *path);
+int  i2c_trace_signal   (int signo, const char *path);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#if !defined (__LIB_I2C_NO_TRACE__)
+//------------------------------------------------------------------------------
+// slot 을 하나 얻어 공통 항목을 채움. trace 가 꺼져 있으면 NULL.
+//------------------------------------------------------------------------------
+static struct i2c_trace_slot *trace_claim (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns,
+                                           int type, int ret, uint64_t *seq)
+{
+    struct i2c_trace_slot *slot;
+    uint64_t idx;
+
+    if (!atomic_load_explicit (&Trace.enable, memory_order_relaxed))
+        return NULL;
+
+    idx  = atomic_fetch_add_explicit (&Trace.head, 1, memory_order_relaxed);
+    slot = &Trace.slot[idx & (I2C_TRACE_MAX - 1)];
+
+    atomic_store_explicit (&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence (memory_order_release);
+
+    slot->e.time_ns = start_ns;
+    slot->e.dur_ns  = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+    slot->e.fd      = bus->fd;
+    slot->e.type    = type;
+    slot->e.ret     = ret;
+    slot->e.err     = (ret < 0) ? errno : 0;
+
+    *seq = idx + 1;
+    return slot;
+}
+
+//------------------------------------------------------------------------------
+static void trace_commit (struct i2c_trace_slot *slot, uint64_t seq)
+{
+    atomic_store_explicit (&slot->seq, seq, memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// idx 번째 기록을 e 에 복사. 덮어쓰였거나 기록중이면 0.
+//------------------------------------------------------------------------------
+static int trace_read (uint64_t idx, struct i2c_trace_entry *e)
+{
+    struct i2c_trace_slot *slot = &Trace.slot[idx & (I2C_TRACE_MAX - 1)];
+    uint64_t seq = atomic_load_explicit (&slot->seq, memory_order_acquire);
+
+    if (seq != idx + 1)
+        return 0;
+
+    *e = slot->e;
+    atomic_thread_fence (memory_order_acquire);
+    if (atomic_load_explicit (&slot->seq, memory_order_relaxed) != seq)
+        return 0;
+
+    e->seq = seq;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// dump 는 signal handler 에서도 호출되므로 printf 계열을 사용하지 않고 직접 format 함.
+// 문자열/10진수는 width 보다 짧으면 앞을 공백 (fill) 으로 채움.
+//------------------------------------------------------------------------------
+static char *fmt_str (char *p, const char *s, int width)
+{
+    width -= strlen (s);
+    while (width-- > 0)
+        *p++ = ' ';
+    while (*s)
+        *p++ = *s++;
+    return p;
+}
+
+//------------------------------------------------------------------------------
+static char *fmt_dec (char *p, int64_t v, int width, char fill)
+{
+    char tmp[24];
+    uint64_t u = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+    int n = 0;
+
+    do {
+        tmp[n++] = '0' + (u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0)
+        tmp[n++] = '-';
+
+    while (width-- > n)
+        *p++ = fill;
+    while (n)
+        *p++ = tmp[--n];
+    return p;
+}
+
+//------------------------------------------------------------------------------
+static char *fmt_hex (char *p, uint32_t v, int digits)
+{
+    while (digits--)
+        *p++ = "0123456789abcdef"[(v >> (digits * 4)) & 0xF];
+    return p;
+}
+
+//------------------------------------------------------------------------------
+// entry 1개를 한 줄로 format. 반환값은 길이 ('\n' 포함).
+//  seq  time(s)  fd  addr  type  rw  cmd  size  len  ret  errno  dur(ns)  data
+//------------------------------------------------------------------------------
+static int trace_format (const struct i2c_trace_entry *e, char *line)
+{
+    static const char *type_str[] = { "?", "smbus", "xfer", "probe" };
+    char *p = line;
+    int i;
+
+    p = fmt_dec (p, e->seq, 8, ' ');
+    p = fmt_dec (p, e->time_ns / 1000000000ull, 10, ' ');
+    *p++ = '.';
+    p = fmt_dec (p, (e->time_ns / 1000) % 1000000, 6, '0');
+    p = fmt_dec (p, e->fd, 5, ' ');
+    p = fmt_str (p, "  0x", 0);
+    p = fmt_hex (p, e->addr, 2);
+    p = fmt_str (p, type_str[(e->type < 4) ? e->type : 0], 7);
+    p = fmt_str (p, "   ", 0);
+    p = fmt_hex (p, e->rw, 2);
+    p = fmt_str (p, "  0x", 0);
+    p = fmt_hex (p, e->command, 2);
+    p = fmt_dec (p, e->size, 5, ' ');
+    p = fmt_dec (p, e->len, 5, ' ');
+    p = fmt_dec (p, e->ret, 5, ' ');
+    p = fmt_dec (p, e->err, 6, ' ');
+    p = fmt_dec (p, e->dur_ns, 11, ' ');
+    p = fmt_str (p, "  ", 0);
+    for (i = 0; (i < e->len) && (i < I2C_TRACE_DATA_MAX); i++) {
+        *p++ = ' ';
+        p = fmt_hex (p, e->data[i], 2);
+    }
+    if (e->len > I2C_TRACE_DATA_MAX)
+        p = fmt_str (p, " ...", 0);
+    *p++ = '\n';
+    return p - line;
+}
+
+//------------------------------------------------------------------------------
+// dump 후 USR1/USR2 는 계속 실행, 그 외 (SIGSEGV, SIGABRT ...) 는 기본 동작으로 종료.
+// (SA_RESETHAND 로 등록하므로 다시 발생시키면 기본 동작이 됨)
+//------------------------------------------------------------------------------
+static void trace_signal_handler (int signo)
+{
+    int fd, err = errno;
+
+    if ((fd = open (TracePath, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0) {
+        i2c_trace_dump (fd);
+        close (fd);
+    }
+    if ((signo != SIGUSR1) && (signo != SIGUSR2))
+        raise (signo);
+
+    errno = err;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// hook (lib_i2c.c) 에서 transaction 마다 호출. data 는 앞의 I2C_TRACE_DATA_MAX byte 만 저장.
+//------------------------------------------------------------------------------
+void i2c_trace_smbus (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, char rw,
+                      uint8_t command, int size, const union i2c_smbus_data *data, int ret)
+{
+    struct i2c_trace_slot *slot;
+    uint64_t seq;
+    int len;
+
+    if ((slot = trace_claim (bus, start_ns, ns, eI2C_TRACE_SMBUS, ret, &seq)) == NULL)
+        return;
+
+    slot->e.addr    = bus->addr;
+    slot->e.rw      = rw;
+    slot->e.command = command;
+    slot->e.size    = size;
+
+    /* 실패한 read 의 data 는 의미 없음 */
+    if ((ret < 0) && (rw == I2C_SMBUS_READ))
+        data = NULL;
+
+    switch (data ? size : I2C_SMBUS_QUICK) {
+        case I2C_SMBUS_BYTE:
+        case I2C_SMBUS_BYTE_DATA:
+            slot->e.data[0] = data->byte;
+            len = 1;
+            break;
+        case I2C_SMBUS_WORD_DATA:
+        case I2C_SMBUS_PROC_CALL:
+            slot->e.data[0] = data->word & 0xFF;
+            slot->e.data[1] = data->word >> 8;
+            len = 2;
+            break;
+        case I2C_SMBUS_BLOCK_DATA:
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+            len = (data->block[0] > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : data->block[0];
+            memcpy (slot->e.data, &data->block[1],
+                    (len < I2C_TRACE_DATA_MAX) ? len : I2C_TRACE_DATA_MAX);
+            break;
+        default:
+            len = 0;
+            break;
+    }
+    slot->e.len = len;
+    trace_commit (slot, seq);
+}
+
+//------------------------------------------------------------------------------
+// combined transfer. addr 은 첫 message, rw 는 처음 8개 message 의 read bit map (bit n = msgs[n]),
+// data 는 모든 message 의 data 를 이어 붙인 것 (실패시 read message 는 제외).
+//------------------------------------------------------------------------------
+void i2c_trace_transfer (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns,
+                         const struct i2c_msg *msgs, int nmsgs, int ret)
+{
+    struct i2c_trace_slot *slot;
+    uint64_t seq;
+    int i, len, n;
+
+    if ((slot = trace_claim (bus, start_ns, ns, eI2C_TRACE_TRANSFER, ret, &seq)) == NULL)
+        return;
+
+    slot->e.addr    = msgs[0].addr;
+    slot->e.rw      = 0;
+    slot->e.command = 0;
+    slot->e.size    = nmsgs;
+
+    for (i = 0, len = 0; i < nmsgs; i++) {
+        if (msgs[i].flags & I2C_M_RD) {
+            if (i < 8)
+                slot->e.rw |= (1u << i);
+            if (ret < 0)
+                continue;
+        }
+        n = I2C_TRACE_DATA_MAX - len;
+        if ((n > 0) && msgs[i].buf)
+            memcpy (&slot->e.data[len], msgs[i].buf, (msgs[i].len < n) ? msgs[i].len : n);
+        len += msgs[i].len;
+    }
+    slot->e.len = (len > UINT16_MAX) ? UINT16_MAX : len;
+    trace_commit (slot, seq);
+}
+
+//------------------------------------------------------------------------------
+void i2c_trace_probe (struct i2c_bus *bus, uint64_t start_ns, uint64_t ns, int addr, int ret)
+{
+    struct i2c_trace_slot *slot;
+    uint64_t seq;
+
+    if ((slot = trace_claim (bus, start_ns, ns, eI2C_TRACE_PROBE, ret, &seq)) == NULL)
+        return;
+
+    slot->e.addr    = addr;
+    slot->e.rw      = 0;
+    slot->e.command = 0;
+    slot->e.size    = 0;
+    slot->e.len     = 0;
+    trace_commit (slot, seq);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 기록 on/off. 이전 상태 반환.
+//------------------------------------------------------------------------------
+int i2c_trace_enable (int enable)
+{
+    return atomic_exchange_explicit (&Trace.enable, enable ? 1 : 0, memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// 지금까지의 기록을 버림 (이후 snapshot/dump 에 나오지 않음).
+//------------------------------------------------------------------------------
+void i2c_trace_clear (void)
+{
+    int i;
+
+    for (i = 0; i < I2C_TRACE_MAX; i++)
+        atomic_store_explicit (&Trace.slot[i].seq, 0, memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// 최근 기록 최대 max 개를 오래된 순서로 buf 에 복사. 복사한 수 반환.
+//------------------------------------------------------------------------------
+int i2c_trace_snapshot (struct i2c_trace_entry *buf, int max)
+{
+    uint64_t idx, head = atomic_load_explicit (&Trace.head, memory_order_acquire);
+    int cnt = 0;
+
+    if ((buf == NULL) || (max <= 0))
+        return 0;
+    if (max > I2C_TRACE_MAX)
+        max = I2C_TRACE_MAX;
+
+    for (idx = (head > (uint64_t)max) ? head - max : 0; idx < head; idx++)
+        if (trace_read (idx, &buf[cnt]))
+            cnt++;
+
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// ring 의 기록을 오래된 순서로 fd 에 text 로 씀 (async-signal-safe). 쓴 entry 수 반환.
+//------------------------------------------------------------------------------
+int i2c_trace_dump (int fd)
+{
+    static const char header[] =
+        "     seq          time(s)   fd  addr   type   rw   cmd size  len  ret errno    dur(ns)   data\n";
+    struct i2c_trace_entry e;
+    uint64_t idx, head = atomic_load_explicit (&Trace.head, memory_order_acquire);
+    char line[160];
+    int cnt = 0;
+
+    if (write (fd, header, sizeof(header) - 1) < 0)
+        return -1;
+
+    for (idx = (head > I2C_TRACE_MAX) ? head - I2C_TRACE_MAX : 0; idx < head; idx++) {
+        if (!trace_read (idx, &e))
+            continue;
+        if (write (fd, line, trace_format (&e, line)) < 0)
+            return -1;
+        cnt++;
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+int i2c_trace_dump_file (const char *path)
+{
+    int fd, cnt;
+
+    if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        fprintf (stderr, "%s : %s open error\n", __func__, path);
+        return -1;
+    }
+    cnt = i2c_trace_dump (fd);
+    close (fd);
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// signo 발생시 trace 를 path 에 dump. path 는 모든 signal 이 공유 (마지막 설정 사용).
+// 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_trace_signal (int signo, const char *path)
+{
+    struct sigaction sa;
+
+    if ((path == NULL) || (strlen (path) >= sizeof(TracePath)))
+        return -1;
+
+    strncpy (TracePath, path, sizeof(TracePath) - 1);
+
+    memset (&sa, 0, sizeof(sa));
+    sa.sa_handler = trace_signal_handler;
+    sa.sa_flags   = SA_RESTART;
+    if ((signo != SIGUSR1) && (signo != SIGUSR2))
+        sa.sa_flags |= SA_RESETHAND;
+    sigemptyset (&sa.sa_mask);
+
+    if (sigaction (signo, &sa, NULL)) {
+        fprintf (stderr, "%s : signal %d error\n", __func__, signo);
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+#else   // #if !defined (__LIB_I2C_NO_TRACE__)
+//------------------------------------------------------------------------------
+// trace 기능 제외 build. API 는 항상 실패 (기록 없음).
+//------------------------------------------------------------------------------
+int i2c_trace_enable (int enable)
+{
+    (void)enable;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+void i2c_trace_clear (void)
+{
+}
+
+//------------------------------------------------------------------------------
+int i2c_trace_snapshot (struct i2c_trace_entry *buf, int max)
+{
+    (void)buf;  (void)max;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_trace_dump (int fd)
+{
+    (void)fd;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int i2c_trace_dump_file (const char *path)
+{
+    (void)path;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int i2c_trace_signal (int signo, const char *path)
+{
+    (void)signo;    (void)path;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+#endif  // #if !defined (__LIB_I2C_NO_TRACE__)
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
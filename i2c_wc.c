@@ -0,0 +1,228 @@
+//------------------------------------------------------------------------------
+/**
+ * @file i2c_wc.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Write-combining buffer (adjacent register writes -> block write).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "lib_i2c.h"
+#include "i2c_bus.h"
+
+//------------------------------------------------------------------------------
+// 한 device (addr) 의 8bit register 에 대한 쓰기 대기 값과 pending bitmap.
+//------------------------------------------------------------------------------
+#define I2C_WC_REG_MAX      256
+#define I2C_WC_MAP_SIZE     (I2C_WC_REG_MAX / 8)
+
+#define MAP_TEST(map, reg)  ((map)[(reg) >> 3] &  (1u << ((reg) & 7)))
+#define MAP_SET(map, reg)   ((map)[(reg) >> 3] |= (1u << ((reg) & 7)))
+
+struct i2c_wc {
+    int         addr;
+    /* pending register 수, 이 값이 threshold 가 되면 flush */
+    int         count;
+    int         threshold;
+    uint8_t     value   [I2C_WC_REG_MAX];
+    uint8_t     pending [I2C_WC_MAP_SIZE];
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+static int      wc_write        (struct i2c_bus *bus, int reg, const uint8_t *buf, int len);
+
+//------------------------------------------------------------------------------
+int  i2c_wc_put         (struct i2c_bus *bus, int reg, uint8_t val);
+int  i2c_wc_get         (struct i2c_bus *bus, int reg, uint8_t *val);
+int  i2c_wc_flush_bus   (struct i2c_bus *bus);
+void i2c_wc_free        (struct i2c_bus *bus);
+
+int  i2c_wc_start       (int fd, int threshold);
+int  i2c_wc_flush       (int fd);
+int  i2c_wc_stop        (int fd);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 연속된 register 를 한번에 씀. I2C block write 를 지원하지 않으면 byte 단위로 씀.
+//------------------------------------------------------------------------------
+static int wc_write (struct i2c_bus *bus, int reg, const uint8_t *buf, int len)
+{
+    union i2c_smbus_data data;
+    int ret, i;
+
+    if ((len == 1) || !(bus->funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+        for (i = 0, ret = 0; i < len; i++) {
+            data.byte = buf[i];
+            if (i2c_bus_smbus (bus, I2C_SMBUS_WRITE, reg + i, I2C_SMBUS_BYTE_DATA, &data)) {
+                i2c_cache_drop (bus, reg + i, 1);
+                ret = -1;
+                continue;
+            }
+            i2c_cache_put (bus, reg + i, &buf[i], 1);
+        }
+        return ret;
+    }
+
+    data.block[0] = len;
+    memcpy (&data.block[1], buf, len);
+    if (i2c_bus_smbus (bus, I2C_SMBUS_WRITE, reg, I2C_SMBUS_I2C_BLOCK_DATA, &data)) {
+        i2c_cache_drop (bus, reg, len);
+        return -1;
+    }
+    i2c_cache_put (bus, reg, buf, len);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// write combining 중이면 reg 에 쓸 값을 buffer 에 넣고 1, 아니면 0 (바로 써야 함).
+// 다른 device 의 값이 남아 있으면 먼저 flush.
+//------------------------------------------------------------------------------
+int i2c_wc_put (struct i2c_bus *bus, int reg, uint8_t val)
+{
+    struct i2c_wc *wc = bus ? bus->wc : NULL;
+
+    if ((wc == NULL) || (reg < 0) || (reg >= I2C_WC_REG_MAX))
+        return 0;
+
+    if (wc->count && (wc->addr != bus->addr))
+        i2c_wc_flush_bus (bus);
+
+    wc->addr       = bus->addr;
+    wc->value[reg] = val;
+    if (!MAP_TEST(wc->pending, reg)) {
+        MAP_SET(wc->pending, reg);
+        wc->count++;
+    }
+    if (wc->count >= wc->threshold)
+        i2c_wc_flush_bus (bus);
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// bus->addr 의 reg 가 아직 쓰지 않은 값이면 1.
+//------------------------------------------------------------------------------
+int i2c_wc_get (struct i2c_bus *bus, int reg, uint8_t *val)
+{
+    struct i2c_wc *wc = bus ? bus->wc : NULL;
+
+    if ((wc == NULL) || !wc->count || (wc->addr != bus->addr) ||
+        (reg < 0) || (reg >= I2C_WC_REG_MAX) || !MAP_TEST(wc->pending, reg))
+        return 0;
+
+    *val = wc->value[reg];
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// pending register 를 연속된 범위로 묶어 32 byte 단위 block write 로 씀.
+// bus 의 slave address 는 호출 전 값으로 복구됨. 모두 성공하면 0, 실패가 있으면 -1.
+//------------------------------------------------------------------------------
+int i2c_wc_flush_bus (struct i2c_bus *bus)
+{
+    struct i2c_wc *wc = bus ? bus->wc : NULL;
+    int reg, len, prev_addr, ret = 0;
+
+    if ((wc == NULL) || !wc->count)
+        return 0;
+
+    prev_addr = bus->addr;
+    if ((prev_addr != wc->addr) && bus->ops->set_addr (bus, wc->addr)) {
+        ret = -1;
+        goto out;
+    }
+
+    for (reg = 0; reg < I2C_WC_REG_MAX; reg += len) {
+        for (len = 0; (reg + len < I2C_WC_REG_MAX) && (len < I2C_SMBUS_BLOCK_MAX); len++)
+            if (!MAP_TEST(wc->pending, reg + len))
+                break;
+
+        if (!len) {
+            len = 1;
+            continue;
+        }
+        if (wc_write (bus, reg, &wc->value[reg], len))
+            ret = -1;
+    }
+    if (prev_addr && (prev_addr != wc->addr))
+        bus->ops->set_addr (bus, prev_addr);
+out:
+    memset (wc->pending, 0, I2C_WC_MAP_SIZE);
+    wc->count = 0;
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+void i2c_wc_free (struct i2c_bus *bus)
+{
+    if (bus->wc == NULL)
+        return;
+
+    i2c_wc_flush_bus (bus);
+    free (bus->wc);
+    bus->wc = NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// write combining 시작. threshold 는 flush 할 pending register 수 (0 이면 I2C_WC_THRESHOLD).
+// 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_wc_start (int fd, int threshold)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (threshold < 0))
+        return -1;
+
+    if (bus->wc == NULL) {
+        if ((bus->wc = calloc (1, sizeof(struct i2c_wc))) == NULL)
+            return -1;
+    }
+    bus->wc->threshold = threshold ? threshold : I2C_WC_THRESHOLD;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_wc_flush (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->wc == NULL))
+        return -1;
+
+    return i2c_wc_flush_bus (bus);
+}
+
+//------------------------------------------------------------------------------
+// 남은 값을 모두 쓰고 write combining 종료. flush 결과를 반환.
+//------------------------------------------------------------------------------
+int i2c_wc_stop (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    int ret;
+
+    if ((bus == NULL) || (bus->wc == NULL))
+        return -1;
+
+    ret = i2c_wc_flush_bus (bus);
+    free (bus->wc);
+    bus->wc = NULL;
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,456 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_bench.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief I2C library throughput/latency benchmark (make bench).
+ * @version 0.2
+ * @date 2026-10-15
+ *
+ * @package apt install minicom
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "lib_i2c.h"
+#include "gpio_i2c.h"
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#if defined(__LIB_I2C_BENCH__)
+
+//------------------------------------------------------------------------------
+#define BENCH_DEV_MAX       16
+#define BENCH_ITER_DEFAULT  1000
+#define BENCH_WARMUP        10
+#define BENCH_BLOCK_MAX     256
+
+/* 기본 test 는 read 계열만 (write test 는 -t 로 직접 지정) */
+#define BENCH_TESTS_DEFAULT "probe,read,read_byte,read_word,read_block,transfer"
+
+enum { OUT_TEXT = 0, OUT_CSV, OUT_JSON };
+
+//------------------------------------------------------------------------------
+static void print_usage (const char *prog)
+{
+    puts("");
+    printf("Usage: %s -D:device [-D:device ...] -a:addr [-r:reg] [-l:len] [-n:count] [-t:tests] [-o:format] [-s]\n", prog);
+    puts("\n"
+         "  -D --Device         Control Device node (repeat to compare buses/clocks)\n"
+         "  -a --addr           slave address (7bit)\n"
+         "  -r --reg            register (command) used by the tests (default 0)\n"
+         "  -l --len            block length for block/transfer tests (default 32)\n"
+         "  -n --count          transactions per test (default 1000)\n"
+         "  -t --tests          comma separated test list (default " BENCH_TESTS_DEFAULT ")\n"
+         "                      probe, read, read_byte, read_word, write, write_byte, write_word,\n"
+         "                      read_block, write_block, read_smbus_block, write_smbus_block,\n"
+         "                      transfer, all\n"
+         "  -o --output         text, csv, json (one object per line)\n"
+         "  -s --stat           print bus transaction statistics per device (stderr for csv/json)\n"
+         "\n"
+         "  e.g) compare GPIO bus clocks on EEPROM(0x50)\n"
+         "       lib_i2c_bench -D GPIO,SCL,480,SDA,479,CLK,100K -D GPIO,SCL,480,SDA,479,CLK,400K -a 0x50\n"
+         "       all tests on the simulated bus, csv output\n"
+         "       lib_i2c_bench -D SIM,REGMAP,0x20 -a 0x20 -t all -o csv\n"
+    );
+    exit(1);
+}
+
+//------------------------------------------------------------------------------
+/* Control server variable */
+//------------------------------------------------------------------------------
+static char *OPT_DEVICE_LIST[BENCH_DEV_MAX];
+static int   OPT_DEVICE_CNT = 0;
+static int   OPT_ADDR  = -1;
+static int   OPT_REG   = 0;
+static int   OPT_LEN   = I2C_SMBUS_BLOCK_MAX;
+static int   OPT_COUNT = BENCH_ITER_DEFAULT;
+static char *OPT_TESTS = BENCH_TESTS_DEFAULT;
+static int   OPT_OUTPUT = OUT_TEXT;
+static int   OPT_STAT   = 0;
+
+//------------------------------------------------------------------------------
+// test 함수는 성공시 전송한 payload byte 수, 실패시 -1.
+//------------------------------------------------------------------------------
+struct bench_test {
+    const char  *name;
+    int         (*run)  (int fd);
+};
+
+struct bench_result {
+    int         count;
+    int         errors;
+    uint64_t    bytes;
+    double      total_s;
+    double      min_us, p50_us, p99_us, p999_us, max_us;
+};
+
+/* read 결과 buffer 와 write pattern 은 분리 (read 가 write pattern 을 덮어쓰지 않도록) */
+static uint8_t BenchBuf[BENCH_BLOCK_MAX];
+static uint8_t BenchData[BENCH_BLOCK_MAX];
+
+//------------------------------------------------------------------------------
+static int run_probe (int fd)
+{
+    return i2c_probe (fd, OPT_ADDR) ? -1 : 0;
+}
+
+static int run_read (int fd)
+{
+    return (i2c_read (fd) < 0) ? -1 : 1;
+}
+
+static int run_read_byte (int fd)
+{
+    return (i2c_read_byte (fd, OPT_REG) < 0) ? -1 : 1;
+}
+
+static int run_read_word (int fd)
+{
+    return (i2c_read_word (fd, OPT_REG) < 0) ? -1 : 2;
+}
+
+static int run_write (int fd)
+{
+    return i2c_write (fd, OPT_REG) ? -1 : 1;
+}
+
+static int run_write_byte (int fd)
+{
+    return i2c_write_byte (fd, OPT_REG, 0x5A) ? -1 : 1;
+}
+
+static int run_write_word (int fd)
+{
+    return i2c_write_word (fd, OPT_REG, 0xA55A) ? -1 : 2;
+}
+
+static int run_read_block (int fd)
+{
+    return i2c_read_block (fd, OPT_REG, BenchBuf, OPT_LEN);
+}
+
+static int run_write_block (int fd)
+{
+    return i2c_write_block (fd, OPT_REG, BenchData, OPT_LEN) ? -1 : OPT_LEN;
+}
+
+static int run_read_smbus_block (int fd)
+{
+    return i2c_read_smbus_block (fd, OPT_REG, BenchBuf);
+}
+
+static int run_write_smbus_block (int fd)
+{
+    int len = (OPT_LEN > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : OPT_LEN;
+
+    return i2c_write_smbus_block (fd, OPT_REG, BenchData, len) ? -1 : len;
+}
+
+/* register write + repeated START + read (I2C_RDWR) */
+static int run_transfer (int fd)
+{
+    uint8_t reg = OPT_REG;
+    struct i2c_msg msgs[2] = {
+        { .addr = OPT_ADDR, .flags = 0,         .len = 1,       .buf = &reg     },
+        { .addr = OPT_ADDR, .flags = I2C_M_RD,  .len = OPT_LEN, .buf = BenchBuf },
+    };
+
+    return (i2c_transfer (fd, msgs, 2) != 2) ? -1 : OPT_LEN;
+}
+
+static const struct bench_test BenchTests[] = {
+    { "probe",              run_probe               },
+    { "read",               run_read                },
+    { "read_byte",          run_read_byte           },
+    { "read_word",          run_read_word           },
+    { "write",              run_write               },
+    { "write_byte",         run_write_byte          },
+    { "write_word",         run_write_word          },
+    { "read_block",         run_read_block          },
+    { "write_block",        run_write_block         },
+    { "read_smbus_block",   run_read_smbus_block    },
+    { "write_smbus_block",  run_write_smbus_block   },
+    { "transfer",           run_transfer            },
+};
+
+#define BENCH_TEST_CNT  (int)(sizeof(BenchTests) / sizeof(BenchTests[0]))
+
+//------------------------------------------------------------------------------
+static void parse_opts (int argc, char *argv[])
+{
+    while (1) {
+        static const struct option lopts[] = {
+            { "Device",     1, 0, 'D' },
+            { "addr",       1, 0, 'a' },
+            { "reg",        1, 0, 'r' },
+            { "len",        1, 0, 'l' },
+            { "count",      1, 0, 'n' },
+            { "tests",      1, 0, 't' },
+            { "output",     1, 0, 'o' },
+            { "stat",       0, 0, 's' },
+            { NULL, 0, 0, 0 },
+        };
+        int c;
+
+        c = getopt_long(argc, argv, "D:a:r:l:n:t:o:sh", lopts, NULL);
+
+        if (c == -1)
+            break;
+
+        switch (c) {
+        case 'D':
+            if (OPT_DEVICE_CNT < BENCH_DEV_MAX)
+                OPT_DEVICE_LIST[OPT_DEVICE_CNT++] = optarg;
+            break;
+        case 'a':
+            OPT_ADDR = strtol(optarg, NULL, 0);
+            break;
+        case 'r':
+            OPT_REG = strtol(optarg, NULL, 0);
+            break;
+        case 'l':
+            OPT_LEN = atoi(optarg);
+            if ((OPT_LEN < 1) || (OPT_LEN > BENCH_BLOCK_MAX))
+                print_usage(argv[0]);
+            break;
+        case 'n':
+            OPT_COUNT = atoi(optarg);
+            if (OPT_COUNT < 1)
+                print_usage(argv[0]);
+            break;
+        case 't':
+            OPT_TESTS = optarg;
+            break;
+        case 'o':
+            if      (!strcasecmp (optarg, "csv"))   OPT_OUTPUT = OUT_CSV;
+            else if (!strcasecmp (optarg, "json"))  OPT_OUTPUT = OUT_JSON;
+            else                                    OPT_OUTPUT = OUT_TEXT;
+            break;
+        case 's':
+            OPT_STAT = 1;
+            break;
+        case 'h':
+        default:
+            print_usage(argv[0]);
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static uint64_t time_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static int cmp_u64 (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------
+// 정렬된 latency 배열의 percentile (nearest-rank)
+//------------------------------------------------------------------------------
+static double percentile_us (const uint64_t *lat, int cnt, double pct)
+{
+    int idx = (int)(pct / 100.0 * cnt + 0.999999) - 1;
+
+    if (idx < 0)        idx = 0;
+    if (idx >= cnt)     idx = cnt - 1;
+    return lat[idx] / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// 실패한 transaction 도 latency 에 포함 (NACK 도 bus 시간을 사용함)
+//------------------------------------------------------------------------------
+static int bench_run (int fd, const struct bench_test *test, uint64_t *lat, struct bench_result *r)
+{
+    uint64_t t_start, t_begin;
+    int i, ret;
+
+    memset (r, 0, sizeof(struct bench_result));
+
+    for (i = 0; i < BENCH_WARMUP; i++)
+        test->run (fd);
+
+    t_begin = time_ns ();
+    for (i = 0; i < OPT_COUNT; i++) {
+        t_start = time_ns ();
+        ret     = test->run (fd);
+        lat[i]  = time_ns () - t_start;
+        if (ret < 0)    r->errors++;
+        else            r->bytes += ret;
+    }
+    r->total_s = (time_ns () - t_begin) / 1000000000.0;
+    r->count   = OPT_COUNT;
+
+    qsort (lat, OPT_COUNT, sizeof(uint64_t), cmp_u64);
+    r->min_us  = lat[0] / 1000.0;
+    r->p50_us  = percentile_us (lat, OPT_COUNT, 50.0);
+    r->p99_us  = percentile_us (lat, OPT_COUNT, 99.0);
+    r->p999_us = percentile_us (lat, OPT_COUNT, 99.9);
+    r->max_us  = lat[OPT_COUNT - 1] / 1000.0;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void print_header (void)
+{
+    switch (OPT_OUTPUT) {
+        case OUT_CSV:
+            printf ("device,clock_hz,addr,test,count,errors,bytes,seconds,txn_per_s,bytes_per_s,"
+                    "min_us,p50_us,p99_us,p999_us,max_us\n");
+            break;
+        case OUT_JSON:
+            break;
+        default:
+            printf ("%-18s %6s %6s %12s %12s %10s %10s %10s %10s\n",
+                "test", "count", "errors", "txn/s", "bytes/s",
+                "p50(us)", "p99(us)", "p999(us)", "max(us)");
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void print_result (const char *device, uint32_t clock_hz,
+                          const struct bench_test *test, struct bench_result *r)
+{
+    double txn_s   = r->total_s > 0 ? r->count / r->total_s : 0;
+    double bytes_s = r->total_s > 0 ? r->bytes / r->total_s : 0;
+
+    switch (OPT_OUTPUT) {
+        case OUT_CSV:
+            printf ("\"%s\",%u,0x%02x,%s,%d,%d,%llu,%.6f,%.1f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                device, clock_hz, OPT_ADDR, test->name, r->count, r->errors,
+                (unsigned long long)r->bytes, r->total_s, txn_s, bytes_s,
+                r->min_us, r->p50_us, r->p99_us, r->p999_us, r->max_us);
+            break;
+        case OUT_JSON:
+            printf ("{\"device\":\"%s\",\"clock_hz\":%u,\"addr\":%d,\"test\":\"%s\","
+                    "\"count\":%d,\"errors\":%d,\"bytes\":%llu,\"seconds\":%.6f,"
+                    "\"txn_per_s\":%.1f,\"bytes_per_s\":%.1f,\"min_us\":%.3f,"
+                    "\"p50_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f}\n",
+                device, clock_hz, OPT_ADDR, test->name, r->count, r->errors,
+                (unsigned long long)r->bytes, r->total_s, txn_s, bytes_s,
+                r->min_us, r->p50_us, r->p99_us, r->p999_us, r->max_us);
+            break;
+        default:
+            printf ("%-18s %6d %6d %12.1f %12.1f %10.2f %10.2f %10.2f %10.2f\n",
+                test->name, r->count, r->errors, txn_s, bytes_s,
+                r->p50_us, r->p99_us, r->p999_us, r->max_us);
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// test 목록 중 name 이 포함되어 있는지 확인 ("all" 은 모든 test)
+//------------------------------------------------------------------------------
+static int test_selected (const char *name)
+{
+    const char *p = OPT_TESTS;
+    int len = strlen (name);
+
+    if (!strcasecmp (OPT_TESTS, "all"))
+        return 1;
+
+    while (p != NULL) {
+        if (!strncasecmp (p, name, len) && ((p[len] == ',') || (p[len] == '\0')))
+            return 1;
+        if ((p = strchr (p, ',')) != NULL)
+            p++;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static int bench_device (const char *device, uint64_t *lat)
+{
+    struct bench_result r;
+    uint32_t clock_hz;
+    int fd, i;
+
+    if ((fd = i2c_open_device (device, OPT_ADDR)) < 0) {
+        fprintf (stderr, "%s : Unable to open %s\n", __func__, device);
+        return -1;
+    }
+    /* GPIO bus 만 clock 을 알 수 있음 (HW, SIM 은 0) */
+    clock_hz = i2c_get_gpio (fd) ? gpio_i2c_get_clock (i2c_get_gpio (fd)) : 0;
+
+    if (OPT_OUTPUT == OUT_TEXT) {
+        printf ("\n%s (addr 0x%02x, clock %u Hz, len %d)\n", device, OPT_ADDR, clock_hz, OPT_LEN);
+        print_header ();
+    }
+
+    for (i = 0; i < BENCH_TEST_CNT; i++) {
+        if (!test_selected (BenchTests[i].name))
+            continue;
+        /* probe 는 slave address 를 바꾸므로 매 test 마다 다시 설정 */
+        i2c_set_addr (fd, OPT_ADDR);
+        bench_run (fd, &BenchTests[i], lat, &r);
+        print_result (device, clock_hz, &BenchTests[i], &r);
+    }
+    /* csv/json 출력은 stdout 을 그대로 parse 할 수 있도록 stderr 로 출력 */
+    if (OPT_STAT)
+        i2c_stat_print (fd, (OPT_OUTPUT == OUT_TEXT) ? stdout : stderr);
+    i2c_close (fd);
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    uint64_t *lat;
+    int i, ret = 0;
+
+    parse_opts(argc, argv);
+
+    if (!OPT_DEVICE_CNT || (OPT_ADDR < 0))
+        print_usage(argv[0]);
+
+    if ((lat = malloc (OPT_COUNT * sizeof(uint64_t))) == NULL)
+        return -1;
+
+    /*
+     * 첫 byte 는 SMBus block count (1 ~ 32) 로 설정.
+     * write_block 이 OPT_REG 에 쓴 값을 read_smbus_block 이 count 로 읽으므로
+     * register map 형태의 device 에서 count 0 (EPROTO) 이 되지 않도록 한다.
+     */
+    for (i = 0; i < BENCH_BLOCK_MAX; i++)
+        BenchData[i] = i;
+    BenchData[0] = (OPT_LEN > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : OPT_LEN;
+
+    /* text 는 device 마다 header 출력 */
+    if (OPT_OUTPUT == OUT_CSV)
+        print_header ();
+    for (i = 0; i < OPT_DEVICE_CNT; i++)
+        if (bench_device (OPT_DEVICE_LIST[i], lat))
+            ret = -1;
+
+    free (lat);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#endif  // #if defined(__LIB_I2C_BENCH__)
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
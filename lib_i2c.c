@@ -22,9 +22,15 @@
 #include <string.h>
 #include <time.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #include "lib_i2c.h"
 #include "gpio_i2c.h"
+#include "gpio_port.h"
+#include "i2c_sim.h"
+#include "i2c_daemon.h"
+#include "i2c_bus.h"
+#include "gpio_delay.h"
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -32,18 +38,53 @@
 //------------------------------------------------------------------------------
 static void toupperstr          (char *p);
 static int  check_i2c_mode      (const char *device_info);
+static int  parse_clock         (const char *str);
+static int  i2c_bus_register    (struct i2c_bus *bus);
+#if !defined (__LIB_I2C_NO_STAT__)
+static int  smbus_data_len      (int size, const union i2c_smbus_data *data);
+#endif
+static int  bus_smbus_once      (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+static int  bus_transfer_once   (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
 
-static int  i2c_set_addr_gpio   (int fd, int device_addr);
-static int  i2c_smbus_gpio      (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data);
-static int  i2c_open_gpio       (const char *device_info);
+static int  i2c_set_addr_gpio   (struct i2c_bus *bus, int device_addr);
+static int  i2c_smbus_gpio      (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+static int  i2c_transfer_gpio   (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+static int  i2c_set_clock_gpio  (struct i2c_bus *bus, int clock_hz);
+static int  i2c_probe_gpio      (struct i2c_bus *bus, int device_addr);
+static int  i2c_recover_gpio    (struct i2c_bus *bus);
+static void i2c_close_gpio      (struct i2c_bus *bus);
+static struct i2c_bus *i2c_open_gpio (const char *device_info);
 
-static int  i2c_set_addr_hw     (int fd, int device_addr);
-static int  i2c_smbus_hw        (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data);
-static int  i2c_open_hw         (const char *device_info);
+static int  i2c_set_addr_sim    (struct i2c_bus *bus, int device_addr);
+static int  i2c_smbus_sim       (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+static int  i2c_transfer_sim    (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+static int  i2c_probe_sim       (struct i2c_bus *bus, int device_addr);
+static void i2c_close_sim       (struct i2c_bus *bus);
+static struct i2c_bus *i2c_open_sim  (const char *device_info);
+
+static int  i2c_set_addr_hw     (struct i2c_bus *bus, int device_addr);
+static int  i2c_smbus_hw        (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+static int  i2c_transfer_hw     (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+static int  i2c_probe_hw        (struct i2c_bus *bus, int device_addr);
+static void i2c_close_hw        (struct i2c_bus *bus);
+static struct i2c_bus *i2c_open_hw   (const char *device_info);
+
+static int  i2c_set_addr_daemon (struct i2c_bus *bus, int device_addr);
+static int  i2c_smbus_daemon    (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+static int  i2c_transfer_daemon (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+static int  i2c_set_clock_daemon(struct i2c_bus *bus, int clock_hz);
+static int  i2c_probe_daemon    (struct i2c_bus *bus, int device_addr);
+static int  i2c_recover_daemon  (struct i2c_bus *bus);
+static void i2c_close_daemon    (struct i2c_bus *bus);
+static struct i2c_bus *i2c_open_daemon (const char *path, const char *device_info);
 
 //------------------------------------------------------------------------------
 int i2c_smbus_access(int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+int i2c_transfer    (int fd, struct i2c_msg *msgs, int nmsgs);
 int i2c_set_addr    (int fd, int device_addr);
+int i2c_set_clock   (int fd, int clock_hz);
+int i2c_probe       (int fd, int device_addr);
+int i2c_recover     (int fd);
 
 int i2c_read        (int fd);
 int i2c_read_byte   (int fd, int reg);
@@ -51,28 +92,340 @@ int i2c_read_word   (int fd, int reg);
 int i2c_write       (int fd, int data);
 int i2c_write_byte  (int fd, int reg, int value);
 int i2c_write_word  (int fd, int reg, int value);
+int i2c_update_bits (int fd, int reg, int mask, int value);
+int i2c_read_block  (int fd, int reg, uint8_t *buf, int len);
+int i2c_write_block (int fd, int reg, const uint8_t *buf, int len);
+int i2c_read_smbus_block  (int fd, int reg, uint8_t *buf);
+int i2c_write_smbus_block (int fd, int reg, const uint8_t *buf, int len);
 int i2c_close       (int fd);
 int i2c_open        (const char *device_info);
 int i2c_open_device (const char *device_info, int device_addr);
 
+int i2c_bus_smbus   (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+int i2c_bus_transfer(struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs);
+int i2c_bus_probe   (struct i2c_bus *bus, int device_addr);
+
+struct i2c_bus  *i2c_bus_open   (const char *device_info);
+struct i2c_bus  *i2c_bus_get    (int fd);
+int              i2c_bus_fd     (struct i2c_bus *bus);
+int              i2c_bus_close  (struct i2c_bus *bus);
+struct gpio_i2c *i2c_get_gpio   (int fd);
+struct i2c_sim  *i2c_get_sim    (int fd);
+
+//------------------------------------------------------------------------------
+static const struct i2c_bus_ops i2c_bus_ops_hw = {
+    .set_addr   = i2c_set_addr_hw,
+    .smbus      = i2c_smbus_hw,
+    .transfer   = i2c_transfer_hw,
+    .set_clock  = NULL,
+    .probe      = i2c_probe_hw,
+    .recover    = NULL,
+    .close      = i2c_close_hw,
+};
+
+static const struct i2c_bus_ops i2c_bus_ops_gpio = {
+    .set_addr   = i2c_set_addr_gpio,
+    .smbus      = i2c_smbus_gpio,
+    .transfer   = i2c_transfer_gpio,
+    .set_clock  = i2c_set_clock_gpio,
+    .probe      = i2c_probe_gpio,
+    .recover    = i2c_recover_gpio,
+    .close      = i2c_close_gpio,
+};
+
+static const struct i2c_bus_ops i2c_bus_ops_sim = {
+    .set_addr   = i2c_set_addr_sim,
+    .smbus      = i2c_smbus_sim,
+    .transfer   = i2c_transfer_sim,
+    .set_clock  = NULL,
+    .probe      = i2c_probe_sim,
+    .recover    = NULL,
+    .close      = i2c_close_sim,
+};
+
+static const struct i2c_bus_ops i2c_bus_ops_daemon = {
+    .set_addr   = i2c_set_addr_daemon,
+    .smbus      = i2c_smbus_daemon,
+    .transfer   = i2c_transfer_daemon,
+    .set_clock  = i2c_set_clock_daemon,
+    .probe      = i2c_probe_daemon,
+    .recover    = i2c_recover_daemon,
+    .close      = i2c_close_daemon,
+};
+
+//------------------------------------------------------------------------------
+// fd -> bus handle table. open/close 만 lock 을 사용하고 조회는 lock 없이 읽음.
+// (같은 bus 를 여러 thread 에서 동시에 사용하는 것은 호출자가 직렬화해야 함)
+//------------------------------------------------------------------------------
+static struct i2c_bus  *I2C_Bus[I2C_BUS_FD_MAX];
+static pthread_mutex_t  I2C_BusLock = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+struct i2c_bus *i2c_bus_get (int fd)
+{
+    if ((fd < 0) || (fd >= I2C_BUS_FD_MAX))
+        return NULL;
+
+    return I2C_Bus[fd];
+}
+
+//------------------------------------------------------------------------------
+int i2c_bus_fd (struct i2c_bus *bus)
+{
+    return bus ? bus->fd : -1;
+}
+
+//------------------------------------------------------------------------------
+struct gpio_i2c *i2c_get_gpio (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->mode != eI2C_MODE_GPIO))
+        return NULL;
+
+    return bus->priv;
+}
+
+//------------------------------------------------------------------------------
+struct i2c_sim *i2c_get_sim (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->mode != eI2C_MODE_SIM))
+        return NULL;
+
+    return bus->priv;
+}
+
+//------------------------------------------------------------------------------
+static int i2c_bus_register (struct i2c_bus *bus)
+{
+    if ((bus->fd < 0) || (bus->fd >= I2C_BUS_FD_MAX)) {
+        fprintf (stderr, "%s : fd(%d) out of range\n", __func__, bus->fd);
+        return -1;
+    }
+    pthread_mutex_lock   (&I2C_BusLock);
+    I2C_Bus[bus->fd] = bus;
+    pthread_mutex_unlock (&I2C_BusLock);
+    return 0;
+}
+
+#if !defined (__LIB_I2C_NO_STAT__)
+//------------------------------------------------------------------------------
+// SMBus transaction 의 data byte 수 (command/count byte 제외).
+//------------------------------------------------------------------------------
+static int smbus_data_len (int size, const union i2c_smbus_data *data)
+{
+    switch (size) {
+        case I2C_SMBUS_BYTE:
+        case I2C_SMBUS_BYTE_DATA:       return 1;
+        case I2C_SMBUS_WORD_DATA:
+        case I2C_SMBUS_PROC_CALL:       return 2;
+        case I2C_SMBUS_BLOCK_DATA:
+        case I2C_SMBUS_I2C_BLOCK_DATA:  return data ? data->block[0] : 0;
+        case I2C_SMBUS_QUICK:
+        default:                        return 0;
+    }
+}
+#endif
+
+//------------------------------------------------------------------------------
+// backend 1회 호출과 통계 (i2c_stat.c) / trace (i2c_trace.c) 기록.
+// 둘 다 제외한 build 에서는 backend 호출만 함.
+//------------------------------------------------------------------------------
+static int bus_smbus_once (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+{
+#if defined (__LIB_I2C_NO_STAT__) && defined (__LIB_I2C_NO_TRACE__)
+    return bus->ops->smbus (bus, rw, command, size, data);
+#else
+    uint64_t start, ns;
+    int ret;
+
+    /* 실패 원인 (errno) 구분을 위해 이전 errno 를 지움 */
+    errno = 0;
+    start = gpio_delay_now ();
+    ret   = bus->ops->smbus (bus, rw, command, size, data);
+    ns    = gpio_delay_now () - start;
+
+    i2c_stat_record (bus, bus->addr, ns, smbus_data_len (size, data), ret);
+    i2c_trace_smbus (bus, start, ns, rw, command, size, data, ret);
+    return ret;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// combined transfer 는 첫 message 의 address 로 기록.
+//------------------------------------------------------------------------------
+static int bus_transfer_once (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
+{
+#if defined (__LIB_I2C_NO_STAT__) && defined (__LIB_I2C_NO_TRACE__)
+    return bus->ops->transfer (bus, msgs, nmsgs);
+#else
+    uint64_t start, ns;
+    int i, bytes, ret;
+
+    errno = 0;
+    start = gpio_delay_now ();
+    ret   = bus->ops->transfer (bus, msgs, nmsgs);
+    ns    = gpio_delay_now () - start;
+
+    for (i = 0, bytes = 0; i < nmsgs; i++)
+        bytes += msgs[i].len;
+
+    i2c_stat_record    (bus, msgs[0].addr, ns, bytes, ret);
+    i2c_trace_transfer (bus, start, ns, msgs, nmsgs, ret);
+    return ret;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// backend 호출 hook. 라이브러리 내부의 모든 transaction 은 이 함수들을 통해 backend 를
+// 호출하므로 HW/GPIO/SIM bus 와 cache sync, write combining flush, async worker 의
+// transaction 에 모두 retry policy 가 적용되고 시도마다 통계/trace 에 기록됨.
+//------------------------------------------------------------------------------
+int i2c_bus_smbus (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+{
+    const struct i2c_retry_policy *policy = i2c_retry_policy (bus, bus->addr);
+    int attempt, ret;
+
+    for (attempt = 0; ; attempt++) {
+        ret = bus_smbus_once (bus, rw, command, size, data);
+        if (!ret || !i2c_retry_next (bus, policy, bus->addr, attempt))
+            return ret;
+    }
+}
+
+//------------------------------------------------------------------------------
+int i2c_bus_transfer (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
+{
+    const struct i2c_retry_policy *policy;
+    uint16_t len[I2C_RDWR_IOCTL_MAX_MSGS];
+    int i, attempt, ret;
+
+    if ((msgs == NULL) || (nmsgs <= 0) || (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS))
+        return bus->ops->transfer (bus, msgs, nmsgs);
+
+    if ((policy = i2c_retry_policy (bus, msgs[0].addr)) == NULL)
+        return bus_transfer_once (bus, msgs, nmsgs);
+
+    /* I2C_M_RECV_LEN 은 실패한 시도에서도 len 이 바뀔 수 있으므로 retry 전에 되돌림 */
+    for (i = 0; i < nmsgs; i++)
+        len[i] = msgs[i].len;
+
+    for (attempt = 0; ; attempt++) {
+        ret = bus_transfer_once (bus, msgs, nmsgs);
+        if ((ret >= 0) || !i2c_retry_next (bus, policy, msgs[0].addr, attempt))
+            return ret;
+        for (i = 0; i < nmsgs; i++)
+            msgs[i].len = len[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+// probe 는 device 유무 확인이므로 retry 하지 않음.
 //------------------------------------------------------------------------------
-int (*fp_i2c_set_addr)      (int fd, int device_addr) = NULL;
-int (*fp_i2c_smbus_access)  (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data) = NULL;
+int i2c_bus_probe (struct i2c_bus *bus, int device_addr)
+{
+#if defined (__LIB_I2C_NO_STAT__) && defined (__LIB_I2C_NO_TRACE__)
+    return bus->ops->probe (bus, device_addr);
+#else
+    uint64_t start, ns;
+    int ret;
 
-int  I2C_Mode = eI2C_MODE_HW;
-int  I2C_SLAVE_ADDR = 0;
+    errno = 0;
+    start = gpio_delay_now ();
+    ret   = bus->ops->probe (bus, device_addr);
+    ns    = gpio_delay_now () - start;
+
+    /* probe 실패는 device 없음 (NACK) */
+    if (ret && (errno != ENXIO) && (errno != EREMOTEIO))
+        errno = ENXIO;
+
+    i2c_stat_record (bus, device_addr, ns, 0, ret ? -1 : 0);
+    i2c_trace_probe (bus, start, ns, device_addr, ret ? -1 : 0);
+    return ret;
+#endif
+}
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 int i2c_smbus_access (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data)
 {
-    return fp_i2c_smbus_access (fd, rw, command, size, data);
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if (bus == NULL)
+        return -1;
+
+    i2c_wc_flush_bus (bus);
+    return i2c_bus_smbus (bus, rw, command, size, data);
+}
+
+//------------------------------------------------------------------------------
+// struct i2c_msg 배열을 repeated START 로 연결하여 한번에 전송. (STOP 은 마지막에 1회)
+// 성공시 전송한 message 수, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_transfer (int fd, struct i2c_msg *msgs, int nmsgs)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if (bus == NULL)
+        return -1;
+
+    i2c_wc_flush_bus (bus);
+    return i2c_bus_transfer (bus, msgs, nmsgs);
 }
 
 //------------------------------------------------------------------------------
 int i2c_set_addr (int fd, int device_addr)
 {
-    return fp_i2c_set_addr (fd, device_addr);
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if (bus == NULL)
+        return -1;
+
+    return bus->ops->set_addr (bus, device_addr);
+}
+
+//------------------------------------------------------------------------------
+// GPIO bus 만 clock 설정 가능. HW bus 는 kernel(dtb) 설정을 따름.
+//------------------------------------------------------------------------------
+int i2c_set_clock (int fd, int clock_hz)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->ops->set_clock == NULL))
+        return -1;
+
+    return bus->ops->set_clock (bus, clock_hz);
+}
+
+//------------------------------------------------------------------------------
+// device_addr 의 응답(ACK) 여부만 확인. 응답하면 0, 없으면 -1.
+// bus 의 slave address 는 device_addr 로 변경됨.
+//------------------------------------------------------------------------------
+int i2c_probe (int fd, int device_addr)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if (bus == NULL)
+        return -1;
+
+    i2c_wc_flush_bus (bus);
+    return i2c_bus_probe (bus, device_addr) ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// SDA 가 잡힌 bus 를 복구 (GPIO bus). 복구할 수 없는 bus (HW, SIM) 는 -1.
+//------------------------------------------------------------------------------
+int i2c_recover (int fd)
+{
+    struct i2c_bus *bus = i2c_bus_get (fd);
+
+    if ((bus == NULL) || (bus->ops->recover == NULL))
+        return -1;
+
+    return bus->ops->recover (bus);
 }
 
 //------------------------------------------------------------------------------
@@ -94,81 +447,279 @@ static int check_i2c_mode (const char *device_info)
     memcpy (str, device_info, sizeof(str)-1);
 
     toupperstr (str);
+    /* "GPIO,..."(sysfs), "GPIOCHIP,..."(chardev), "GPIOMEM,..."(mmap) 모두 GPIO mode */
     if (!strncmp ("GPIO", str, sizeof(str)-1))
         return eI2C_MODE_GPIO;
     if (!strncmp ("/DEV", str, sizeof(str)-1))
         return eI2C_MODE_HW;
+    if (!strncmp ("SIM,", str, sizeof(str)-1))
+        return eI2C_MODE_SIM;
 
     return -1;
 }
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-static int i2c_set_addr_gpio (int fd, int device_addr)
+static int i2c_set_addr_gpio (struct i2c_bus *bus, int device_addr)
 {
-    I2C_SLAVE_ADDR = (fd == FD_GPIO_I2C) ? (device_addr << 1) : 0;
+    bus->addr = device_addr;
     return 0;
 }
 
 //------------------------------------------------------------------------------
-static int i2c_smbus_gpio (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+static int i2c_smbus_gpio (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
 {
     struct i2c_smbus_ioctl_data args ;
 
-    if (fd != FD_GPIO_I2C)  return -1;
     args.read_write = rw ;
     args.command    = command ;
     args.size       = size ;
     args.data       = data ;
-    return gpio_i2c_ctrl (&args);
+    return gpio_i2c_ctrl (bus->priv, bus->addr, &args);
 }
 
 //------------------------------------------------------------------------------
-static int i2c_open_gpio (const char *device_info)
+static int i2c_transfer_gpio (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
 {
-    char gpio_info [64], *p;
-    int scl_gpio, sda_gpio, i;
+    return gpio_i2c_transfer (bus->priv, msgs, nmsgs);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_set_clock_gpio (struct i2c_bus *bus, int clock_hz)
+{
+    return gpio_i2c_set_clock (bus->priv, clock_hz);
+}
+
+//------------------------------------------------------------------------------
+// START + address(write) + ACK 확인 + STOP (SMBus Quick write)
+//------------------------------------------------------------------------------
+static int i2c_probe_gpio (struct i2c_bus *bus, int device_addr)
+{
+    bus->addr = device_addr;
+    return i2c_smbus_gpio (bus, I2C_SMBUS_WRITE, 0, I2C_SMBUS_QUICK, NULL);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_recover_gpio (struct i2c_bus *bus)
+{
+    return gpio_i2c_recover (bus->priv);
+}
+
+//------------------------------------------------------------------------------
+static void i2c_close_gpio (struct i2c_bus *bus)
+{
+    gpio_i2c_close (bus->priv);
+    close (bus->fd);
+}
+
+//------------------------------------------------------------------------------
+/* "100000", "100K", "1M" */
+//------------------------------------------------------------------------------
+static int parse_clock (const char *str)
+{
+    char *end;
+    long clock_hz = strtol (str, &end, 10);
+
+    switch (toupper (*end)) {
+        case 'K':   clock_hz *= 1000;       break;
+        case 'M':   clock_hz *= 1000000;    break;
+        default :                           break;
+    }
+    return (int)clock_hz;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// device_info
+//   sysfs    : "GPIO,SCL,<gpio>,SDA,<gpio>"
+//   chardev  : "GPIOCHIP,<chip num or node>,SCL,<line offset>,SDA,<line offset>"
+//   mmap     : "GPIOMEM,<board>,SCL,<gpio>,SDA,<gpio>[,PATH,<gpiomem node or file>]"
+//   multi-lane : SDA 를 반복하면 lane 추가 (",SDA,<a>,SDA,<b>...", 최대 GPIO_LANE_MAX)
+//   option   : ",CLK,<hz>" bus clock (e.g. 10K, 100K, 400K, default 10K)
+//              ",OD,1" open-drain (clock stretching), ",STRETCH,<us>" stretching timeout
+//              ",KEEP,1" sysfs line 을 close 후에도 export 상태로 유지
+//------------------------------------------------------------------------------
+static struct i2c_bus *i2c_open_gpio (const char *device_info)
+{
+    char gpio_info [256], chip[64], path[128], *p, *save;
+    int scl_gpio = -1, sda_gpio[GPIO_LANE_MAX], lanes = 0, use_chip = 0, use_mmap = 0;
+    int clock_hz = GPIO_I2C_DEFAULT_CLK, open_drain = 0, stretch_us = 0, keep = 0, i;
+    struct gpio_i2c *gi;
+    struct i2c_bus *bus;
 
     memset (gpio_info, 0, sizeof(gpio_info));
-    memcpy (gpio_info, device_info, strlen (device_info));
+    memset (chip, 0, sizeof(chip));
+    memset (path, 0, sizeof(path));
+    strncpy (gpio_info, device_info, sizeof(gpio_info) -1);
+
+    if ((p = strtok_r (gpio_info, ",", &save)) == NULL)
+        return NULL;
 
-    if ((p = strtok (gpio_info, ",")) != NULL) {
+    toupperstr (p);
+    if (!strncmp (p, "GPIOCHIP", sizeof("GPIOCHIP"))) {
+        if ((p = strtok_r (NULL, ",", &save)) == NULL)
+            return NULL;
+        strncpy (chip, p, sizeof(chip) -1);
+        use_chip = 1;
+    }
+    else if (!strncmp (p, "GPIOMEM", sizeof("GPIOMEM"))) {
+        /* chip 에 board 이름 저장 */
+        if ((p = strtok_r (NULL, ",", &save)) == NULL)
+            return NULL;
+        strncpy (chip, p, sizeof(chip) -1);
+        use_mmap = 1;
+    }
+    else if (strncmp (p, "GPIO", sizeof("GPIO")))
+        return NULL;
+
+    while ((p = strtok_r (NULL, ",", &save)) != NULL) {
         toupperstr (p);
-        if (strncmp (p, "GPIO", sizeof("GPIO")))   return -1;
-
-        for (i = 0, scl_gpio = 0, sda_gpio = 0; i < 2; i++ ) {
-            p = strtok (NULL, ","); toupperstr (p);
-            if (!strncmp (p, "SCL", sizeof("SCL"))) {
-                p = strtok (NULL, ",");
-                scl_gpio = atoi (p);
-            }
-            else if (!strncmp (p, "SDA", sizeof("SDA"))) {
-                p = strtok (NULL, ",");
-                sda_gpio = atoi (p);
-            }
+        if (!strncmp (p, "SCL", sizeof("SCL"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            scl_gpio = atoi (p);
+        }
+        else if (!strncmp (p, "SDA", sizeof("SDA"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            if (lanes >= GPIO_LANE_MAX)                     return NULL;
+            sda_gpio[lanes++] = atoi (p);
+        }
+        else if (!strncmp (p, "PATH", sizeof("PATH"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            strncpy (path, p, sizeof(path) -1);
+        }
+        else if (!strncmp (p, "CLK", sizeof("CLK"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            clock_hz = parse_clock (p);
+        }
+        else if (!strncmp (p, "OD", sizeof("OD"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            open_drain = atoi (p);
+        }
+        else if (!strncmp (p, "STRETCH", sizeof("STRETCH"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            stretch_us = atoi (p);
+        }
+        else if (!strncmp (p, "KEEP", sizeof("KEEP"))) {
+            if ((p = strtok_r (NULL, ",", &save)) == NULL)   return NULL;
+            keep = atoi (p);
         }
-        if (!scl_gpio || !sda_gpio)     return -1;
     }
+    /* sysfs gpio 번호 0 은 사용하지 않음 (기존 동작 유지), chip line offset 은 0 부터 */
+    if ((scl_gpio < 0) || !lanes)                   return NULL;
+    if (!use_chip && !scl_gpio)                     return NULL;
+    for (i = 0; i < lanes; i++)
+        if ((sda_gpio[i] < 0) || (!use_chip && !sda_gpio[i]))
+            return NULL;
+
+    if (use_chip)
+        gi = gpio_i2c_init_chip (chip, scl_gpio, sda_gpio, lanes);
+    else if (use_mmap)
+        gi = gpio_i2c_init_mmap (chip, path[0] ? path : NULL, scl_gpio, sda_gpio, lanes);
+    else
+        gi = gpio_i2c_init (scl_gpio, sda_gpio, lanes, keep);
+
+    if (gi == NULL)
+        return NULL;
+
+    if (gpio_i2c_set_clock (gi, clock_hz) ||
+        (open_drain && gpio_i2c_set_open_drain (gi, 1, stretch_us > 0 ? stretch_us : 0)) ||
+        ((bus = calloc (1, sizeof(struct i2c_bus))) == NULL)) {
+        gpio_i2c_close (gi);
+        return NULL;
+    }
+    /* GPIO bus 는 실제 device 가 없으므로 /dev/null 을 열어 고유한 fd 번호를 확보 */
+    if ((bus->fd = open ("/dev/null", O_RDONLY | O_CLOEXEC)) < 0) {
+        gpio_i2c_close (gi);
+        free (bus);
+        return NULL;
+    }
+    bus->ops   = &i2c_bus_ops_gpio;
+    bus->mode  = eI2C_MODE_GPIO;
+    bus->priv  = gi;
+    bus->funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE |
+                 I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA |
+                 I2C_FUNC_SMBUS_BLOCK_DATA | I2C_FUNC_SMBUS_I2C_BLOCK;
+    return bus;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int i2c_set_addr_sim (struct i2c_bus *bus, int device_addr)
+{
+    bus->addr = device_addr;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static int i2c_smbus_sim (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+{
+    return i2c_sim_smbus (bus->priv, bus->addr, rw, command, size, data);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_transfer_sim (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
+{
+    return i2c_sim_transfer (bus->priv, msgs, nmsgs);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_probe_sim (struct i2c_bus *bus, int device_addr)
+{
+    bus->addr = device_addr;
+    return i2c_sim_smbus (bus->priv, device_addr, I2C_SMBUS_WRITE, 0, I2C_SMBUS_QUICK, NULL);
+}
 
-    fp_i2c_smbus_access    = i2c_smbus_gpio;
-    fp_i2c_set_addr        = i2c_set_addr_gpio;
+//------------------------------------------------------------------------------
+static void i2c_close_sim (struct i2c_bus *bus)
+{
+    i2c_sim_close (bus->priv);
+    close (bus->fd);
+}
 
-    return gpio_i2c_init (scl_gpio, sda_gpio);
+//------------------------------------------------------------------------------
+// device_info : "SIM,<type>,<addr>[,<option>,<value>...]..." (i2c_sim.c 참고)
+//------------------------------------------------------------------------------
+static struct i2c_bus *i2c_open_sim (const char *device_info)
+{
+    struct i2c_sim *sim;
+    struct i2c_bus *bus;
+
+    if ((sim = i2c_sim_open (device_info)) == NULL)
+        return NULL;
+
+    if ((bus = calloc (1, sizeof(struct i2c_bus))) == NULL) {
+        i2c_sim_close (sim);
+        return NULL;
+    }
+    /* GPIO bus 와 같이 /dev/null 로 고유한 fd 번호를 확보 */
+    if ((bus->fd = open ("/dev/null", O_RDONLY | O_CLOEXEC)) < 0) {
+        i2c_sim_close (sim);
+        free (bus);
+        return NULL;
+    }
+    bus->ops   = &i2c_bus_ops_sim;
+    bus->mode  = eI2C_MODE_SIM;
+    bus->priv  = sim;
+    bus->funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE |
+                 I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA |
+                 I2C_FUNC_SMBUS_BLOCK_DATA | I2C_FUNC_SMBUS_I2C_BLOCK;
+    return bus;
 }
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-static int i2c_set_addr_hw (int fd, int device_addr)
+static int i2c_set_addr_hw (struct i2c_bus *bus, int device_addr)
 {
-    if (ioctl (fd, I2C_SLAVE, device_addr) < 0) {
+    if (ioctl (bus->fd, I2C_SLAVE, device_addr) < 0) {
         fprintf (stderr, "Can't setup device : device adddr is 0x%02x\n", device_addr);
         return -1;
     }
+    bus->addr = device_addr;
     return 0;
 }
 
 //------------------------------------------------------------------------------
-static int i2c_smbus_hw (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+static int i2c_smbus_hw (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
 {
     struct i2c_smbus_ioctl_data args ;
 
@@ -176,20 +727,141 @@ static int i2c_smbus_hw (int fd, char rw, uint8_t command, int size, union i2c_s
     args.command    = command ;
     args.size       = size ;
     args.data       = data ;
-    return ioctl (fd, I2C_SMBUS, &args) ;
+    return ioctl (bus->fd, I2C_SMBUS, &args) ;
+}
+
+//------------------------------------------------------------------------------
+static int i2c_transfer_hw (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
+{
+    struct i2c_rdwr_ioctl_data rdwr;
+
+    rdwr.msgs  = msgs;
+    rdwr.nmsgs = nmsgs;
+    return ioctl (bus->fd, I2C_RDWR, &rdwr);
+}
+
+//------------------------------------------------------------------------------
+// i2cdetect 와 동일하게 adapter 가 지원하면 SMBus Quick write, 아니면 read byte 사용.
+// 0x30~0x37, 0x50~0x5F 는 Quick write 로 write-protect 가 바뀌는 EEPROM 이 있으므로
+// read byte 를 사용. kernel driver 가 사용중인 address(EBUSY)는 device 가 있는 것으로 처리.
+//------------------------------------------------------------------------------
+static int i2c_probe_hw (struct i2c_bus *bus, int device_addr)
+{
+    union i2c_smbus_data data;
+    int use_read;
+
+    if (ioctl (bus->fd, I2C_SLAVE, device_addr) < 0)
+        return (errno == EBUSY) ? 0 : -1;
+    bus->addr = device_addr;
+
+    use_read = ((device_addr >= 0x30) && (device_addr <= 0x37)) ||
+               ((device_addr >= 0x50) && (device_addr <= 0x5F)) ||
+               !(bus->funcs & I2C_FUNC_SMBUS_QUICK);
+
+    if (use_read) {
+        if (!(bus->funcs & I2C_FUNC_SMBUS_READ_BYTE))
+            return -1;
+        return i2c_smbus_hw (bus, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data) < 0 ? -1 : 0;
+    }
+    return i2c_smbus_hw (bus, I2C_SMBUS_WRITE, 0, I2C_SMBUS_QUICK, NULL) < 0 ? -1 : 0;
 }
 
 //------------------------------------------------------------------------------
-static int i2c_open_hw (const char *device_info)
+static void i2c_close_hw (struct i2c_bus *bus)
 {
+    close (bus->fd);
+}
+
+//------------------------------------------------------------------------------
+static struct i2c_bus *i2c_open_hw (const char *device_info)
+{
+    struct i2c_bus *bus;
     int fd;
+
     if ((fd = open (device_info, O_RDWR)) < 0) {
         fprintf (stderr, "%s : Unable to open I2C device : %s\n", __func__, device_info);
-        return -1;
+        return NULL;
     }
-    fp_i2c_smbus_access    = i2c_smbus_hw;
-    fp_i2c_set_addr        = i2c_set_addr_hw;
-    return fd;
+    if ((bus = calloc (1, sizeof(struct i2c_bus))) == NULL) {
+        close (fd);
+        return NULL;
+    }
+    bus->ops  = &i2c_bus_ops_hw;
+    bus->fd   = fd;
+    bus->mode = eI2C_MODE_HW;
+    /* I2C_FUNCS 를 지원하지 않는 adapter 는 read byte 만 가능한 것으로 처리 */
+    if (ioctl (fd, I2C_FUNCS, &bus->funcs) < 0)
+        bus->funcs = I2C_FUNC_SMBUS_READ_BYTE;
+    return bus;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// daemon bus (i2c_daemon.c). slave address 는 요청마다 daemon 으로 보냄.
+//------------------------------------------------------------------------------
+static int i2c_set_addr_daemon (struct i2c_bus *bus, int device_addr)
+{
+    bus->addr = device_addr;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static int i2c_smbus_daemon (struct i2c_bus *bus, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+{
+    return i2c_daemon_smbus (bus->priv, bus->addr, rw, command, size, data);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_transfer_daemon (struct i2c_bus *bus, struct i2c_msg *msgs, int nmsgs)
+{
+    return i2c_daemon_transfer (bus->priv, msgs, nmsgs);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_set_clock_daemon (struct i2c_bus *bus, int clock_hz)
+{
+    return i2c_daemon_set_clock (bus->priv, clock_hz);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_probe_daemon (struct i2c_bus *bus, int device_addr)
+{
+    bus->addr = device_addr;
+    return i2c_daemon_probe (bus->priv, device_addr);
+}
+
+//------------------------------------------------------------------------------
+static int i2c_recover_daemon (struct i2c_bus *bus)
+{
+    return i2c_daemon_recover (bus->priv);
+}
+
+//------------------------------------------------------------------------------
+static void i2c_close_daemon (struct i2c_bus *bus)
+{
+    /* 연결 socket (bus->fd) 도 같이 닫힘 */
+    i2c_daemon_close (bus->priv);
+}
+
+//------------------------------------------------------------------------------
+// path 의 daemon 에 device_info 의 bus 를 요청. fd 는 daemon 연결 socket.
+//------------------------------------------------------------------------------
+static struct i2c_bus *i2c_open_daemon (const char *path, const char *device_info)
+{
+    struct i2c_daemon *d;
+    struct i2c_bus *bus;
+
+    if ((bus = calloc (1, sizeof(struct i2c_bus))) == NULL)
+        return NULL;
+
+    if ((d = i2c_daemon_connect (path, device_info, &bus->fd, &bus->funcs)) == NULL) {
+        free (bus);
+        return NULL;
+    }
+    bus->ops  = &i2c_bus_ops_daemon;
+    bus->mode = eI2C_MODE_DAEMON;
+    bus->priv = d;
+    return bus;
 }
 
 //------------------------------------------------------------------------------
@@ -207,23 +879,39 @@ int i2c_read (int fd)
 //------------------------------------------------------------------------------
 int i2c_read_byte (int fd, int reg)
 {
+    struct i2c_bus *bus = i2c_bus_get (fd);
     union i2c_smbus_data data;
 
+    if (i2c_wc_get (bus, reg, &data.byte) || i2c_cache_get (bus, reg, &data.byte, 1))
+        return data.byte;
+
     if (i2c_smbus_access (fd, I2C_SMBUS_READ, reg, I2C_SMBUS_BYTE_DATA, &data))
         return -1 ;
-    else
-        return data.byte & 0xFF ;
+
+    i2c_cache_put (bus, reg, &data.byte, 1);
+    return data.byte & 0xFF ;
 }
 
+//------------------------------------------------------------------------------
+// word 는 cache 의 val_bits 에 따라 reg(LSB), reg + 1(MSB) 두 register 또는 register 1개로
+// cache 됨. 아직 쓰지 않은 write combining byte 도 반영됨 (device read 는 먼저 flush 됨).
 //------------------------------------------------------------------------------
 int i2c_read_word (int fd, int reg)
 {
+    struct i2c_bus *bus = i2c_bus_get (fd);
     union i2c_smbus_data data;
+    uint8_t val[2];
+
+    if (i2c_cache_get_word (bus, reg, val))
+        return val[0] | (val[1] << 8);
 
     if (i2c_smbus_access (fd, I2C_SMBUS_READ, reg, I2C_SMBUS_WORD_DATA, &data))
         return -1 ;
-    else
-        return data.word & 0xFFFF ;
+
+    val[0] = data.word & 0xFF;
+    val[1] = data.word >> 8;
+    i2c_cache_put_word (bus, reg, val);
+    return data.word & 0xFFFF ;
 }
 
 //------------------------------------------------------------------------------
@@ -232,46 +920,219 @@ int i2c_write (int fd, int data)
     return i2c_smbus_access (fd, I2C_SMBUS_WRITE, data, I2C_SMBUS_BYTE, NULL) ;
 }
 
+//------------------------------------------------------------------------------
+// write 실패시 device 의 값을 알 수 없으므로 cache 값을 버림.
 //------------------------------------------------------------------------------
 int i2c_write_byte (int fd, int reg, int value)
 {
+    struct i2c_bus *bus = i2c_bus_get (fd);
     union i2c_smbus_data data ;
 
     data.byte = value ;
-    return i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_BYTE_DATA, &data) ;
+    if (i2c_wc_put (bus, reg, data.byte))
+        return 0;
+
+    if (i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_BYTE_DATA, &data)) {
+        i2c_cache_drop (bus, reg, 1);
+        return -1;
+    }
+    i2c_cache_put (bus, reg, &data.byte, 1);
+    return 0;
 }
 
 //------------------------------------------------------------------------------
 int i2c_write_word (int fd, int reg, int value)
 {
+    struct i2c_bus *bus = i2c_bus_get (fd);
     union i2c_smbus_data data ;
+    uint8_t val[2];
 
     data.word = value ;
-    return i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_WORD_DATA, &data) ;
+    if (i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_WORD_DATA, &data)) {
+        i2c_cache_drop (bus, reg, 2);
+        return -1;
+    }
+    val[0] = value & 0xFF;
+    val[1] = (value >> 8) & 0xFF;
+    i2c_cache_put_word (bus, reg, val);
+    return 0;
 }
 
 //------------------------------------------------------------------------------
-int i2c_close (int fd)
+// reg 의 mask bit 만 value 로 바꿈 (read-modify-write). 현재 값은 쓰기 대기값, cache,
+// device 순서로 찾으며, device read 는 write combining buffer 를 flush 하지 않으므로
+// 같은 register 의 여러 update 는 flush 때 한번의 write 가 됨.
+// 값이 바뀌지 않으면 쓰지 않음. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_update_bits (int fd, int reg, int mask, int value)
 {
-    if (fd && (I2C_Mode == eI2C_MODE_HW))
-        close (fd);
+    struct i2c_bus *bus = i2c_bus_get (fd);
+    union i2c_smbus_data data;
+    uint8_t old;
+
+    if (bus == NULL)
+        return -1;
+
+    if (!i2c_wc_get (bus, reg, &old) && !i2c_cache_get (bus, reg, &old, 1)) {
+        if (i2c_bus_smbus (bus, I2C_SMBUS_READ, reg, I2C_SMBUS_BYTE_DATA, &data))
+            return -1;
+        old = data.byte;
+        i2c_cache_put (bus, reg, &old, 1);
+    }
+    data.byte = (old & ~mask) | (value & mask);
+    if (data.byte == old)
+        return 0;
+
+    return i2c_write_byte (fd, reg, data.byte);
+}
 
-    /* gpio i2c slave address clear */
-    I2C_SLAVE_ADDR = 0;
+//------------------------------------------------------------------------------
+// I2C block read (count byte 없음). register auto-increment 를 이용하여
+// I2C_SMBUS_BLOCK_MAX(32) 단위로 나누어 읽음. 성공시 읽은 byte 수, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_read_block (int fd, int reg, uint8_t *buf, int len)
+{
+    union i2c_smbus_data data;
+    int pos, size;
+
+    if ((buf == NULL) || (len <= 0))
+        return -1;
+
+    for (pos = 0; pos < len; pos += size) {
+        size = (len - pos) > I2C_SMBUS_BLOCK_MAX ? I2C_SMBUS_BLOCK_MAX : (len - pos);
+        data.block[0] = size;
+        if (i2c_smbus_access (fd, I2C_SMBUS_READ, reg + pos, I2C_SMBUS_I2C_BLOCK_DATA, &data))
+            return -1;
+        memcpy (&buf[pos], &data.block[1], size);
+    }
+    return len;
+}
+
+//------------------------------------------------------------------------------
+// I2C block write (count byte 없음). 32 byte 단위로 나누어 씀. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_write_block (int fd, int reg, const uint8_t *buf, int len)
+{
+    union i2c_smbus_data data;
+    int pos, size;
 
+    if ((buf == NULL) || (len <= 0))
+        return -1;
+
+    for (pos = 0; pos < len; pos += size) {
+        size = (len - pos) > I2C_SMBUS_BLOCK_MAX ? I2C_SMBUS_BLOCK_MAX : (len - pos);
+        data.block[0] = size;
+        memcpy (&data.block[1], &buf[pos], size);
+        if (i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg + pos, I2C_SMBUS_I2C_BLOCK_DATA, &data)) {
+            i2c_cache_drop (i2c_bus_get (fd), reg + pos, len - pos);
+            return -1;
+        }
+        i2c_cache_put (i2c_bus_get (fd), reg + pos, &buf[pos], size);
+    }
     return 0;
 }
 
 //------------------------------------------------------------------------------
-int i2c_open (const char *device_info)
+// SMBus block read (slave 가 count 를 먼저 보냄). buf 는 32 byte 이상. 성공시 count.
+//------------------------------------------------------------------------------
+int i2c_read_smbus_block (int fd, int reg, uint8_t *buf)
 {
-    I2C_Mode = check_i2c_mode (device_info);
+    union i2c_smbus_data data;
 
-    switch (I2C_Mode) {
-        case eI2C_MODE_HW:      return i2c_open_hw   (device_info);
-        case eI2C_MODE_GPIO:    return i2c_open_gpio (device_info);
-        default :               return -1;
+    if (buf == NULL)
+        return -1;
+
+    if (i2c_smbus_access (fd, I2C_SMBUS_READ, reg, I2C_SMBUS_BLOCK_DATA, &data))
+        return -1;
+
+    if (data.block[0] > I2C_SMBUS_BLOCK_MAX)
+        return -1;
+
+    memcpy (buf, &data.block[1], data.block[0]);
+    return data.block[0];
+}
+
+//------------------------------------------------------------------------------
+// SMBus block write (count byte 를 먼저 전송). len 은 1 ~ 32. 성공시 0, 실패시 -1.
+//------------------------------------------------------------------------------
+int i2c_write_smbus_block (int fd, int reg, const uint8_t *buf, int len)
+{
+    union i2c_smbus_data data;
+
+    if ((buf == NULL) || (len <= 0) || (len > I2C_SMBUS_BLOCK_MAX))
+        return -1;
+
+    data.block[0] = len;
+    memcpy (&data.block[1], buf, len);
+    return i2c_smbus_access (fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_BLOCK_DATA, &data);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+struct i2c_bus *i2c_bus_open (const char *device_info)
+{
+    struct i2c_bus *bus;
+    const char *path;
+    int mode;
+
+    if ((device_info == NULL) || ((mode = check_i2c_mode (device_info)) < 0))
+        return NULL;
+
+    /* daemon 이 있으면 (환경 변수 LIB_I2C_DAEMON) bus 는 daemon 이 열고 요청만 전달 */
+    if ((path = i2c_daemon_path ()) != NULL)
+        mode = eI2C_MODE_DAEMON;
+
+    switch (mode) {
+        case eI2C_MODE_HW:      bus = i2c_open_hw   (device_info);  break;
+        case eI2C_MODE_GPIO:    bus = i2c_open_gpio (device_info);  break;
+        case eI2C_MODE_SIM:     bus = i2c_open_sim  (device_info);  break;
+        case eI2C_MODE_DAEMON:  bus = i2c_open_daemon (path, device_info);  break;
+        default :               return NULL;
     }
+    if (bus == NULL)
+        return NULL;
+
+    if (i2c_stat_alloc (bus) || i2c_bus_register (bus)) {
+        i2c_stat_free (bus);
+        bus->ops->close (bus);
+        free (bus);
+        return NULL;
+    }
+    return bus;
+}
+
+//------------------------------------------------------------------------------
+int i2c_bus_close (struct i2c_bus *bus)
+{
+    if (bus == NULL)
+        return -1;
+
+    pthread_mutex_lock   (&I2C_BusLock);
+    if (I2C_Bus[bus->fd] == bus)
+        I2C_Bus[bus->fd] = NULL;
+    pthread_mutex_unlock (&I2C_BusLock);
+
+    /* async worker 가 남은 요청을 끝내고 멈춘 뒤에 pending write 를 flush */
+    i2c_async_free (bus);
+    i2c_wc_free (bus);
+    bus->ops->close (bus);
+    i2c_cache_free (bus);
+    i2c_retry_free (bus);
+    i2c_stat_free (bus);
+    free (bus);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int i2c_close (int fd)
+{
+    return i2c_bus_close (i2c_bus_get (fd));
+}
+
+//------------------------------------------------------------------------------
+int i2c_open (const char *device_info)
+{
+    return i2c_bus_fd (i2c_bus_open (device_info));
 }
 
 //------------------------------------------------------------------------------
@@ -291,4 +1152,3 @@ int i2c_open_device (const char *device_info, int device_addr)
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-
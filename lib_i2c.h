@@ -16,6 +16,7 @@
 #define __LIB_I2C_H__
 
 //------------------------------------------------------------------------------
+#include <stdio.h>
 #include <stdint.h>
 #include <sys/ioctl.h>
 #include <asm/ioctl.h>
@@ -23,26 +24,204 @@
 #include <linux/i2c-dev.h>
 
 //------------------------------------------------------------------------------
-#define FD_GPIO_I2C     127
-
 enum {
     eI2C_MODE_HW = 0,
     eI2C_MODE_GPIO,
+    eI2C_MODE_SIM,
+    /* 다른 process (i2c_daemon) 가 소유한 bus */
+    eI2C_MODE_DAEMON,
     eI2C_MODE_END
 };
 
-extern int  I2C_Mode;
-extern int  I2C_SLAVE_ADDR;
+//------------------------------------------------------------------------------
+// bus handle. bus 마다 backend, slave address, gpio 설정을 따로 가지므로
+// 여러 bus 를 동시에 (bus 당 thread 1개) 사용할 수 있음.
+// 기존 fd 기반 함수는 fd -> handle table 을 통해 동작함.
+//------------------------------------------------------------------------------
+typedef struct i2c_bus i2c_bus_t;
+struct gpio_i2c;
+struct i2c_sim;
+
+extern i2c_bus_t *i2c_bus_open  (const char *device_info);
+extern i2c_bus_t *i2c_bus_get   (int fd);
+extern int        i2c_bus_fd    (i2c_bus_t *bus);
+extern int        i2c_bus_close (i2c_bus_t *bus);
+/* GPIO bus 의 context (GPIO bus 가 아니면 NULL) */
+extern struct gpio_i2c *i2c_get_gpio (int fd);
+/* SIM bus 의 context (SIM bus 가 아니면 NULL) */
+extern struct i2c_sim  *i2c_get_sim  (int fd);
+
+//------------------------------------------------------------------------------
+// register cache (write-through). i2c_cache_attach 된 device 의
+// i2c_read_byte/i2c_read_word 는 volatile/precious 가 아닌 register 를 cache 에서 읽고,
+// i2c_write_byte/i2c_write_word/i2c_write_block 은 device 에 쓴 후 cache 를 갱신함.
+// 그 외 함수(i2c_transfer, i2c_smbus_access ...)로 register 를 바꾼 경우 invalidate 필요.
+// map 은 register 당 1bit 의 bitmap (I2C_CACHE_MAP_SET 으로 설정).
+// val_bits 8 (auto-increment 8bit register) 은 word 를 reg, reg + 1 두 register 로 cache 하고,
+// val_bits 16 (LM75, TMP102, INA219 등) 은 register 마다 word 1개를 cache 함.
+//------------------------------------------------------------------------------
+#define I2C_CACHE_MAP_SIZE          32
+#define I2C_CACHE_MAP_SET(map, reg) ((map)[((reg) & 0xFF) >> 3] |= (1u << ((reg) & 7)))
+
+extern int i2c_cache_attach     (int fd, int device_addr, int val_bits,
+                                 const uint8_t *volatile_map, const uint8_t *precious_map);
+extern int i2c_cache_detach     (int fd, int device_addr);
+extern int i2c_cache_invalidate (int fd, int device_addr);
+extern int i2c_cache_sync       (int fd, int device_addr);
+
+//------------------------------------------------------------------------------
+// write combining. i2c_wc_start 후 i2c_write_byte/i2c_update_bits 는 바로 쓰지 않고
+// buffer 에 모았다가 flush 때 연속된 register 를 block write (auto-increment) 로 씀.
+// 같은 register 에 여러번 쓰면 마지막 값만 써지고 순서는 register 순서로 바뀜.
+// (FIFO/data port 처럼 쓰기마다 의미가 있는 register 는 사용하지 말 것)
+// pending 수가 threshold 가 되거나, 다른 device 로 바꾸거나, 다른 transaction 전에 flush 됨.
+//------------------------------------------------------------------------------
+#define I2C_WC_THRESHOLD            32
+
+extern int i2c_wc_start         (int fd, int threshold);
+extern int i2c_wc_flush         (int fd);
+extern int i2c_wc_stop          (int fd);
+
+//------------------------------------------------------------------------------
+// retry policy. 실패한 SMBus/transfer transaction 을 errno 가 errnos 에 있으면 retries 번까지
+// 다시 시도. 대기 시간은 backoff_us 부터 2배씩 늘어나 backoff_max_us 에서 멈춤
+// (backoff_max_us 0 : 고정). errnos 가 비어 있으면 (errnos[0] == 0) ENXIO, EREMOTEIO,
+// EAGAIN, EBUSY, ETIMEDOUT, EIO. device policy 가 bus 기본 policy 보다 우선함.
+// 기본은 retry 하지 않음.
+//------------------------------------------------------------------------------
+#define I2C_RETRY_ERRNO_MAX         8
+
+struct i2c_retry_policy {
+    int     retries;
+    int     backoff_us;
+    int     backoff_max_us;
+    /* retry 할 errno 목록 (0 으로 끝남) */
+    int     errnos[I2C_RETRY_ERRNO_MAX];
+};
+
+/* device_addr -1 : bus 기본 policy, policy NULL : 해제 */
+extern int i2c_retry_set        (int fd, int device_addr, const struct i2c_retry_policy *policy);
+/* SDA 가 잡힌 bus 복구 (GPIO bus 만, 실패한 transaction 후에는 자동으로 실행됨) */
+extern int i2c_recover          (int fd);
+
+//------------------------------------------------------------------------------
+// 24Cxx serial EEPROM. write 는 page 경계에 맞춘 page write 후 ACK polling 으로 write cycle
+// 종료를 확인하고, read/verify 는 block read (256 byte 단위) 를 사용함.
+// I2C_FUNC_I2C 가 없는 adapter 는 SMBus I2C block (32 byte) 으로 처리.
+//------------------------------------------------------------------------------
+struct i2c_eeprom {
+    /* 7bit slave address (24Cxx : 0x50) */
+    int         addr;
+    uint32_t    size;
+    /* page write 크기 (byte, 최대 256) */
+    int         page;
+    /* memory address byte 수 (1 or 2, 0 : 256 byte 보다 크면 2). 1 byte address 로
+       256 byte 보다 큰 EEPROM (24C04/08/16) 은 slave address 하위 bit 로 block 선택 */
+    int         addr_bytes;
+    /* write cycle 최대 시간 (ACK polling timeout, 0 : 10ms) */
+    int         twr_us;
+};
+
+extern int i2c_eeprom_wait      (int fd, const struct i2c_eeprom *ee);
+extern int i2c_eeprom_read      (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 uint8_t *buf, uint32_t len);
+extern int i2c_eeprom_write     (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 const uint8_t *buf, uint32_t len);
+extern int i2c_eeprom_verify    (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 const uint8_t *buf, uint32_t len);
+/* write 후 verify */
+extern int i2c_eeprom_program   (int fd, const struct i2c_eeprom *ee, uint32_t offset,
+                                 const uint8_t *buf, uint32_t len);
+
+//------------------------------------------------------------------------------
+// transaction 통계. bus 의 모든 transaction 을 slave address 별로 count (lock 없는
+// atomic counter) 하고 latency 를 log2 histogram 에 기록. -D__LIB_I2C_NO_STAT__ 로
+// build 하면 기록 code 가 제거되고 아래 API 는 -1 (percentile 은 0) 을 돌려줌.
+// histogram bucket 0 : 512ns 미만, bucket b : 2^(b+8) ~ 2^(b+9) ns (상한 I2C_STAT_HIST_NS)
+//------------------------------------------------------------------------------
+#define I2C_STAT_HIST_MAX           20
+#define I2C_STAT_HIST_NS(b)         (1ull << ((b) + 9))
+
+struct i2c_stat_info {
+    uint64_t    transactions;
+    /* 성공한 transaction 의 data byte 수 */
+    uint64_t    bytes;
+    /* 실패 중 address/data NACK (ENXIO, EREMOTEIO) 와 그 외 error */
+    uint64_t    nacks;
+    uint64_t    errors;
+    uint64_t    retries;
+    /* transaction 시간 합계 */
+    uint64_t    time_ns;
+    uint64_t    hist[I2C_STAT_HIST_MAX];
+};
+
+/* device_addr -1 : bus 전체 합계 */
+extern int      i2c_stat_get        (int fd, int device_addr, struct i2c_stat_info *info);
+extern int      i2c_stat_reset      (int fd);
+extern uint64_t i2c_stat_percentile (const struct i2c_stat_info *info, double pct);
+extern int      i2c_stat_print      (int fd, FILE *fp);
+
+//------------------------------------------------------------------------------
+// transaction trace. 모든 bus 의 transaction 을 전역 ring buffer (최근 I2C_TRACE_MAX 개)
+// 에 lock 없이 기록. 기본으로 켜져 있으며 -D__LIB_I2C_NO_TRACE__ 로 build 하면 제거됨.
+// i2c_trace_dump 는 signal handler 에서도 사용 가능 (printf/malloc 사용 안함).
+//------------------------------------------------------------------------------
+#define I2C_TRACE_MAX               2048
+#define I2C_TRACE_DATA_MAX          8
+
+enum {
+    eI2C_TRACE_SMBUS = 1,
+    eI2C_TRACE_TRANSFER,
+    eI2C_TRACE_PROBE,
+};
+
+struct i2c_trace_entry {
+    /* 기록 순서 (1 부터) */
+    uint64_t    seq;
+    /* 시작 시간 (CLOCK_MONOTONIC ns) 과 소요 시간 */
+    uint64_t    time_ns;
+    uint32_t    dur_ns;
+    int16_t     fd;
+    uint8_t     type;
+    uint8_t     addr;
+    /* SMBus : read_write, transfer : 처음 8개 message 의 read bit map (bit n = msgs[n]) */
+    uint8_t     rw;
+    uint8_t     command;
+    /* SMBus : size (I2C_SMBUS_*), transfer : message 수 */
+    uint8_t     size;
+    /* data byte 수 (앞의 I2C_TRACE_DATA_MAX byte 만 data 에 저장) */
+    uint16_t    len;
+    uint8_t     data[I2C_TRACE_DATA_MAX];
+    /* 결과와 실패시 errno */
+    int16_t     ret;
+    int16_t     err;
+};
+
+extern int  i2c_trace_enable    (int enable);
+extern void i2c_trace_clear     (void);
+extern int  i2c_trace_snapshot  (struct i2c_trace_entry *buf, int max);
+extern int  i2c_trace_dump      (int fd);
+extern int  i2c_trace_dump_file (const char *path);
+/* signo (SIGUSR1, SIGSEGV ...) 발생시 path 에 dump. USR1/USR2 외에는 dump 후 종료 */
+extern int  i2c_trace_signal    (int signo, const char *path);
 
 //------------------------------------------------------------------------------
 extern int i2c_smbus_access (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data);
+extern int i2c_transfer     (int fd, struct i2c_msg *msgs, int nmsgs);
 extern int i2c_set_addr     (int fd, int device_addr);
+extern int i2c_set_clock    (int fd, int clock_hz);
+extern int i2c_probe        (int fd, int device_addr);
 extern int i2c_read         (int fd);
 extern int i2c_read_byte    (int fd, int reg);
 extern int i2c_read_word    (int fd, int reg);
 extern int i2c_write        (int fd, int data);
 extern int i2c_write_byte   (int fd, int reg, int value);
 extern int i2c_write_word   (int fd, int reg, int value);
+extern int i2c_update_bits  (int fd, int reg, int mask, int value);
+extern int i2c_read_block   (int fd, int reg, uint8_t *buf, int len);
+extern int i2c_write_block  (int fd, int reg, const uint8_t *buf, int len);
+extern int i2c_read_smbus_block  (int fd, int reg, uint8_t *buf);
+extern int i2c_write_smbus_block (int fd, int reg, const uint8_t *buf, int len);
 extern int i2c_close        (int fd);
 extern int i2c_open         (const char *device_info);
 extern int i2c_open_device  (const char *device_info, int device_addr);
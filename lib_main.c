@@ -29,8 +29,13 @@
 #include <sys/mman.h>
 #include <linux/fb.h>
 #include <getopt.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
 
 #include "lib_i2c.h"
+#include "gpio_i2c.h"
+#include "i2c_daemon.h"
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -40,14 +45,33 @@
 static void print_usage (const char *prog)
 {
     puts("");
-    printf("Usage: %s [-D:device] [-b] [-w]\n", prog);
+    printf("Usage: %s [-D:device] [-a] [-j:jobs] [-r] [-b] [-w] [-e:edges] [-t:cycles] [-s] [-T:file] [-d:socket]\n", prog);
     puts("\n"
-         "  -D --Device         Control Device node\n"
+         "  -D --Device         Control Device node (repeat for multi bus scan)\n"
+         "  -a --all            scan all /dev/i2c-* nodes (and -D buses) in parallel\n"
+         "  -j --jobs           max scan threads for multi bus scan (default 4)\n"
+         "  -r --read           read func used (default : probe func, address ACK only)\n"
          "  -b --byte_read      byte_read func used\n"
          "  -w --word_read      word_read func used\n"
+         "  -e --edge_bench     GPIO bus SCL toggle benchmark (edges/sec)\n"
+         "  -t --clock_test     GPIO bus clock self-test (achieved clock, jitter)\n"
+         "  -s --stat           print bus transaction statistics after the scan\n"
+         "  -T --trace          write the transaction trace to file at exit\n"
+         "                      (also on SIGUSR1, SIGSEGV, SIGABRT)\n"
+         "  -d --daemon         run as bus owner daemon on the socket (until SIGINT/SIGTERM),\n"
+         "                      clients with LIB_I2C_DAEMON=socket open buses through it\n"
          "\n"
          "  e.g) find i2c device from i2c-node\n"
          "       lib_i2c -D /dev/i2c-0\n"
+         "       scan every i2c-node and a GPIO bus with 8 threads\n"
+         "       lib_i2c -a -D GPIO,SCL,480,SDA,479 -j 8\n"
+         "       GPIO SCL edge benchmark (100000 edges)\n"
+         "       lib_i2c -D GPIO,SCL,480,SDA,479 -e 100000\n"
+         "       GPIO 100KHz bus clock self-test (1000 cycles)\n"
+         "       lib_i2c -D GPIO,SCL,480,SDA,479,CLK,100K -t 1000\n"
+         "       share buses between processes\n"
+         "       lib_i2c -d /tmp/lib_i2c.sock &\n"
+         "       LIB_I2C_DAEMON=/tmp/lib_i2c.sock lib_i2c -D /dev/i2c-0\n"
     );
     exit(1);
 }
@@ -55,8 +79,20 @@ static void print_usage (const char *prog)
 //------------------------------------------------------------------------------
 /* Control server variable */
 //------------------------------------------------------------------------------
+#define SCAN_BUS_MAX        64
+#define SCAN_JOBS_DEFAULT   4
+
 static char *OPT_DEVICE_NODE    = NULL;
+static char *OPT_DEVICE_LIST[SCAN_BUS_MAX];
+static int   OPT_DEVICE_CNT = 0;
+static int   OPT_SCAN_ALL = 0;
+static int   OPT_SCAN_JOBS = SCAN_JOBS_DEFAULT;
 static int   OPT_MODE = 0;
+static int   OPT_EDGE_BENCH = 0;
+static int   OPT_CLOCK_TEST = 0;
+static int   OPT_STAT = 0;
+static char *OPT_TRACE_FILE = NULL;
+static char *OPT_DAEMON_SOCK = NULL;
 
 //------------------------------------------------------------------------------
 // 문자열 변경 함수. 입력 포인터는 반드시 메모리가 할당되어진 변수여야 함.
@@ -84,20 +120,44 @@ static void parse_opts (int argc, char *argv[])
     while (1) {
         static const struct option lopts[] = {
             { "Device",     1, 0, 'D' },
+            { "all",        0, 0, 'a' },
+            { "jobs",       1, 0, 'j' },
+            { "read",       0, 0, 'r' },
             { "read_word",  0, 0, 'w' },
             { "read_byte",  0, 0, 'b' },
+            { "edge_bench", 1, 0, 'e' },
+            { "clock_test", 1, 0, 't' },
+            { "stat",       0, 0, 's' },
+            { "trace",      1, 0, 'T' },
+            { "daemon",     1, 0, 'd' },
             { NULL, 0, 0, 0 },
         };
         int c;
 
-        c = getopt_long(argc, argv, "D:wbh", lopts, NULL);
+        c = getopt_long(argc, argv, "D:aj:rwbe:t:sT:d:h", lopts, NULL);
 
         if (c == -1)
             break;
 
         switch (c) {
         case 'D':
-            OPT_DEVICE_NODE = optarg;
+            if (OPT_DEVICE_NODE == NULL)
+                OPT_DEVICE_NODE = optarg;
+            if (OPT_DEVICE_CNT < SCAN_BUS_MAX)
+                OPT_DEVICE_LIST[OPT_DEVICE_CNT++] = optarg;
+            break;
+        /* multi bus scan */
+        case 'a':
+            OPT_SCAN_ALL = 1;
+            break;
+        case 'j':
+            OPT_SCAN_JOBS = atoi(optarg);
+            if (OPT_SCAN_JOBS < 1)
+                OPT_SCAN_JOBS = 1;
+            break;
+        /* detect read (receive byte) */
+        case 'r':
+            OPT_MODE = 3;
             break;
         /* detect word read */
         case 'w':
@@ -107,6 +167,26 @@ static void parse_opts (int argc, char *argv[])
         case 'b':
             OPT_MODE = 2;
             break;
+        /* gpio edge benchmark */
+        case 'e':
+            OPT_EDGE_BENCH = atoi(optarg);
+            break;
+        /* gpio clock self-test */
+        case 't':
+            OPT_CLOCK_TEST = atoi(optarg);
+            break;
+        /* transaction statistics */
+        case 's':
+            OPT_STAT = 1;
+            break;
+        /* transaction trace dump file */
+        case 'T':
+            OPT_TRACE_FILE = optarg;
+            break;
+        /* bus owner daemon socket */
+        case 'd':
+            OPT_DAEMON_SOCK = optarg;
+            break;
         case 'h':
         default:
             print_usage(argv[0]);
@@ -122,19 +202,16 @@ static void parse_opts (int argc, char *argv[])
 #define I2C_ADDR_END        0x77
 
 //------------------------------------------------------------------------------
-int detect_i2c (int fd)
+// found[addr] 에 ack 여부 저장. 찾은 device 수 반환.
+//------------------------------------------------------------------------------
+static int scan_i2c (int fd, uint8_t *found)
 {
     int i, cnt, ret;
 
-    switch (OPT_MODE) {
-        default:
-        case 0: printf ("%s : i2c_read func used.\n", __func__);        break;
-        case 1: printf ("%s : i2c_read_word func used.\n", __func__);   break;
-        case 2: printf ("%s : i2c_read_byte func used.\n", __func__);   break;
-    }
-
     for (i = I2C_ADDR_START, cnt = 0; i < I2C_ADDR_END; i++) {
-        i2c_set_addr(fd, i);
+        found[i] = 0;
+        if (OPT_MODE)
+            i2c_set_addr(fd, i);
         switch (OPT_MODE) {
             case 1:
                 ret = i2c_read_word (fd, 0);
@@ -142,23 +219,299 @@ int detect_i2c (int fd)
             case 2:
                 ret = i2c_read_byte (fd, 0);
                 break;
+            case 3:
+                ret = i2c_read (fd);
+                break;
             case 0:
             default:
-                ret = i2c_read (fd);
+                ret = i2c_probe (fd, i);
                 break;
         }
         if(ret != -1) {
-            printf ("I2C ack detect %s (Device Addr : 0x%02x)\n",
-                OPT_DEVICE_NODE, i);
+            found[i] = 1;
             cnt ++;
         }
     }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+static void print_scan_func (const char *func)
+{
+    switch (OPT_MODE) {
+        default:
+        case 0: printf ("%s : i2c_probe func used.\n", func);       break;
+        case 3: printf ("%s : i2c_read func used.\n", func);        break;
+        case 1: printf ("%s : i2c_read_word func used.\n", func);   break;
+        case 2: printf ("%s : i2c_read_byte func used.\n", func);   break;
+    }
+}
+
+//------------------------------------------------------------------------------
+int detect_i2c (int fd)
+{
+    uint8_t found[I2C_ADDR_END];
+    int i, cnt;
+
+    print_scan_func (__func__);
+
+    cnt = scan_i2c (fd, found);
+    for (i = I2C_ADDR_START; i < I2C_ADDR_END; i++) {
+        if (found[i])
+            printf ("I2C ack detect %s (Device Addr : 0x%02x)\n",
+                OPT_DEVICE_NODE, i);
+    }
     if (!cnt)
         printf ("I2C Device not found!\n");
 
     return cnt ? 0 : 1;
 }
 
+//------------------------------------------------------------------------------
+// Multi bus scan : bus 목록을 worker thread(최대 OPT_SCAN_JOBS 개)가 나누어 scan.
+//------------------------------------------------------------------------------
+struct scan_result {
+    char    *device;
+    int     status;     /* 0 : ok, -1 : open error */
+    int     cnt;
+    double  time_ms;
+    uint8_t found[I2C_ADDR_END];
+    /* bus 전체 통계 (OPT_STAT) */
+    struct i2c_stat_info stat;
+};
+
+struct scan_pool {
+    struct scan_result  *result;
+    int                 cnt;
+    int                 next;
+    pthread_mutex_t     lock;
+};
+
+//------------------------------------------------------------------------------
+static double elapsed_ms (struct timespec *t_start)
+{
+    struct timespec t_end;
+
+    clock_gettime (CLOCK_MONOTONIC, &t_end);
+    return (t_end.tv_sec  - t_start->tv_sec)  * 1000.0 +
+           (t_end.tv_nsec - t_start->tv_nsec) / 1000000.0;
+}
+
+//------------------------------------------------------------------------------
+static void *scan_worker (void *arg)
+{
+    struct scan_pool *pool = arg;
+    struct scan_result *r;
+    struct timespec t_start;
+    int idx, fd;
+
+    while (1) {
+        pthread_mutex_lock   (&pool->lock);
+        idx = pool->next++;
+        pthread_mutex_unlock (&pool->lock);
+
+        if (idx >= pool->cnt)
+            break;
+
+        r = &pool->result[idx];
+        clock_gettime (CLOCK_MONOTONIC, &t_start);
+        if ((fd = i2c_open (r->device)) < 0) {
+            r->status = -1;
+            continue;
+        }
+        r->cnt     = scan_i2c (fd, r->found);
+        r->time_ms = elapsed_ms (&t_start);
+        if (OPT_STAT)
+            i2c_stat_get (fd, -1, &r->stat);
+        i2c_close (fd);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int i2c_node_filter (const struct dirent *d)
+{
+    return !strncmp (d->d_name, "i2c-", strlen("i2c-"));
+}
+
+//------------------------------------------------------------------------------
+// i2c-N 의 bus 번호 순서로 정렬 (i2c-10 이 i2c-2 뒤에 오도록)
+//------------------------------------------------------------------------------
+static int i2c_node_sort (const struct dirent **a, const struct dirent **b)
+{
+    return atoi((*a)->d_name + strlen("i2c-")) - atoi((*b)->d_name + strlen("i2c-"));
+}
+
+//------------------------------------------------------------------------------
+// /dev/i2c-* (bus 번호 순서) 와 -D 로 지정된 bus 를 합쳐서 scan 목록 작성.
+//------------------------------------------------------------------------------
+static int scan_list (char **list, int max)
+{
+    struct dirent **node;
+    int i, j, n, cnt = 0;
+
+    if (OPT_SCAN_ALL && ((n = scandir ("/dev", &node, i2c_node_filter, i2c_node_sort)) >= 0)) {
+        for (i = 0; i < n; i++) {
+            if (cnt < max) {
+                list[cnt] = malloc (strlen("/dev/") + strlen(node[i]->d_name) + 1);
+                sprintf (list[cnt++], "/dev/%s", node[i]->d_name);
+            }
+            free (node[i]);
+        }
+        free (node);
+    }
+    for (i = 0; i < OPT_DEVICE_CNT; i++) {
+        for (j = 0; j < cnt; j++)
+            if (!strcmp (list[j], OPT_DEVICE_LIST[i]))
+                break;
+        if ((j == cnt) && (cnt < max))
+            list[cnt++] = strdup (OPT_DEVICE_LIST[i]);
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// bus 별 transaction 통계 (worker 가 i2c_close 전에 저장한 합계).
+//------------------------------------------------------------------------------
+static void print_scan_stat (struct scan_pool *pool)
+{
+    int i;
+
+    printf ("\n%-40s %8s %8s %8s %10s %10s %10s\n",
+        "Bus", "Txn", "NACK", "Error", "avg(us)", "p50(us)", "p99(us)");
+    for (i = 0; i < pool->cnt; i++) {
+        struct i2c_stat_info *st = &pool->result[i].stat;
+
+        if (pool->result[i].status || !st->transactions)
+            continue;
+        printf ("%-40s %8llu %8llu %8llu %10.1f %10.1f %10.1f\n", pool->result[i].device,
+            (unsigned long long)st->transactions, (unsigned long long)st->nacks,
+            (unsigned long long)st->errors, st->time_ns / 1000.0 / st->transactions,
+            i2c_stat_percentile (st, 50.0) / 1000.0,
+            i2c_stat_percentile (st, 99.0) / 1000.0);
+    }
+}
+
+//------------------------------------------------------------------------------
+int detect_i2c_all (void)
+{
+    char *list[SCAN_BUS_MAX];
+    struct scan_pool pool;
+    pthread_t threads[SCAN_BUS_MAX];
+    struct timespec t_start;
+    int i, j, jobs, created, err, total = 0;
+    double wall_ms;
+
+    print_scan_func (__func__);
+
+    if ((pool.cnt = scan_list (list, SCAN_BUS_MAX)) == 0) {
+        printf ("I2C bus not found!\n");
+        return 1;
+    }
+    if ((pool.result = calloc (pool.cnt, sizeof(struct scan_result))) == NULL) {
+        printf ("%s error : out of memory\n", __func__);
+        for (i = 0; i < pool.cnt; i++)
+            free (list[i]);
+        return 1;
+    }
+    pool.next   = 0;
+    pthread_mutex_init (&pool.lock, NULL);
+    for (i = 0; i < pool.cnt; i++)
+        pool.result[i].device = list[i];
+
+    jobs = (OPT_SCAN_JOBS < pool.cnt) ? OPT_SCAN_JOBS : pool.cnt;
+
+    clock_gettime (CLOCK_MONOTONIC, &t_start);
+    for (i = 0; i < jobs; i++) {
+        if ((err = pthread_create (&threads[i], NULL, scan_worker, &pool))) {
+            printf ("%s error : thread create (%s)\n", __func__, strerror (err));
+            break;
+        }
+    }
+    /* 생성된 thread 만 join. 하나도 없으면 직접 scan (남은 bus 는 생성된 worker 가 가져감) */
+    if ((created = i) == 0)
+        scan_worker (&pool);
+    for (i = 0; i < created; i++)
+        pthread_join (threads[i], NULL);
+    jobs = created ? created : 1;
+    wall_ms = elapsed_ms (&t_start);
+
+    printf ("\n%-40s %5s %10s  %s\n", "Bus", "Found", "Time(ms)", "Device Addr");
+    for (i = 0; i < pool.cnt; i++) {
+        struct scan_result *r = &pool.result[i];
+
+        printf ("%-40s ", r->device);
+        if (r->status) {
+            printf ("%5s %10s  open error\n", "-", "-");
+            continue;
+        }
+        printf ("%5d %10.1f ", r->cnt, r->time_ms);
+        for (j = I2C_ADDR_START; j < I2C_ADDR_END; j++)
+            if (r->found[j])
+                printf (" 0x%02x", j);
+        printf ("%s\n", r->cnt ? "" : "  -");
+        total += r->cnt;
+    }
+    printf ("\nTotal : %d bus, %d device, scan time %.1f ms (%d jobs)\n",
+        pool.cnt, total, wall_ms, jobs);
+
+    if (OPT_STAT)
+        print_scan_stat (&pool);
+
+    for (i = 0; i < pool.cnt; i++)
+        free (list[i]);
+    free (pool.result);
+    pthread_mutex_destroy (&pool.lock);
+
+    return total ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+// -T : 종료시 trace 를 file 로 저장. 실행 중 (SIGUSR1) 이나 비정상 종료시에도 저장.
+//------------------------------------------------------------------------------
+static void trace_exit (void)
+{
+    int cnt = i2c_trace_dump_file (OPT_TRACE_FILE);
+
+    if (cnt < 0)
+        printf ("Trace is not available (built with __LIB_I2C_NO_TRACE__).\n");
+    else
+        printf ("%s : %d transactions\n", OPT_TRACE_FILE, cnt);
+}
+
+//------------------------------------------------------------------------------
+static void trace_setup (void)
+{
+    i2c_trace_signal (SIGUSR1, OPT_TRACE_FILE);
+    i2c_trace_signal (SIGSEGV, OPT_TRACE_FILE);
+    i2c_trace_signal (SIGABRT, OPT_TRACE_FILE);
+    atexit (trace_exit);
+}
+
+//------------------------------------------------------------------------------
+// -d : bus owner daemon. SIGINT/SIGTERM 으로 종료 (연결된 bus 를 모두 닫음).
+//------------------------------------------------------------------------------
+static void daemon_signal (int signo)
+{
+    (void)signo;
+    i2c_daemon_stop ();
+}
+
+//------------------------------------------------------------------------------
+static int daemon_main (void)
+{
+    struct sigaction sa;
+
+    memset (&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigaction (SIGINT,  &sa, NULL);
+    sigaction (SIGTERM, &sa, NULL);
+
+    printf ("daemon : %s\n", OPT_DAEMON_SOCK);
+    fflush (stdout);
+    return i2c_daemon_run (OPT_DAEMON_SOCK) ? 1 : 0;
+}
+
 //------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------
 int main (int argc, char *argv[])
@@ -167,14 +520,54 @@ int main (int argc, char *argv[])
 
     parse_opts(argc, argv);
 
+    if (OPT_TRACE_FILE != NULL)
+        trace_setup ();
+
+    if (OPT_DAEMON_SOCK != NULL)
+        return daemon_main ();
+
+    if (OPT_SCAN_ALL || (OPT_DEVICE_CNT > 1))
+        return detect_i2c_all ();
+
     if (OPT_DEVICE_NODE == NULL)
         print_usage(argv[0]);
 
     if ((fd = i2c_open(OPT_DEVICE_NODE)) < 0)
         return -1;
 
+    if (OPT_EDGE_BENCH) {
+        double edges = gpio_i2c_bench (i2c_get_gpio (fd), OPT_EDGE_BENCH);
+
+        if (edges < 0)
+            printf ("Edge benchmark is only supported on GPIO bus.\n");
+        else
+            printf ("%s : %d edges, %.0f edges/sec\n",
+                OPT_DEVICE_NODE, OPT_EDGE_BENCH, edges);
+        i2c_close (fd);
+        return 0;
+    }
+
+    if (OPT_CLOCK_TEST) {
+        struct gpio_i2c_clock_stat stat;
+
+        if (gpio_i2c_selftest (i2c_get_gpio (fd), OPT_CLOCK_TEST, &stat))
+            printf ("Clock self-test is only supported on GPIO bus.\n");
+        else {
+            printf ("%s : clock %u Hz, achieved %.1f Hz (%d cycles)\n",
+                OPT_DEVICE_NODE, stat.clock_hz, stat.achieved_hz, stat.cycles);
+            printf ("half period avg %.0f ns, min %.0f ns, max %.0f ns, jitter %.0f ns\n",
+                stat.half_avg_ns, stat.half_min_ns, stat.half_max_ns, stat.jitter_ns);
+            printf ("delay calib : sleep slack %u ns, clock cost %u ns\n",
+                stat.sleep_slack_ns, stat.clock_cost_ns);
+        }
+        i2c_close (fd);
+        return 0;
+    }
+
     detect_i2c (fd);
-    close(fd);
+    if (OPT_STAT && i2c_stat_print (fd, stdout))
+        printf ("Statistics are not available (built with __LIB_I2C_NO_STAT__).\n");
+    i2c_close (fd);
 
     return 0;
 }